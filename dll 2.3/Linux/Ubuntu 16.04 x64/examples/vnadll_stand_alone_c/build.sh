@@ -6,7 +6,26 @@ if [ ! -f libvnadll.so ]; then
 	cp ../../build/dlls/vnadll/libvnadll.so libvnadll.so
 fi
 
-g++ -o vnadll_test.o -c -fPIC "-D UNICODE" "-D NDEBUG" "-D _UNICODE" "-D _CONSOLE" "-D LINUX" "-D GCC" -fstack-protector -std=c++11 -D_FILE_OFFSET_BITS=64 -Wno-unused-variable -Wno-write-strings -Wno-redundant-decls -fno-omit-frame-pointer -g -Og -fstack-check -I. vnadll_test.cpp
-g++ -o vnadll_test.bin -std=c++11 -pthread -g vnadll_test.o libvnadll.so
+CXXFLAGS=(-fPIC "-D UNICODE" "-D NDEBUG" "-D _UNICODE" "-D _CONSOLE" "-D LINUX" "-D GCC" -fstack-protector -std=c++11 -D_FILE_OFFSET_BITS=64 -Wno-unused-variable -Wno-write-strings -Wno-redundant-decls -fno-omit-frame-pointer -g -Og -fstack-check -I.)
+
+# Host-side extensions (vnadll_ext.h)
+EXT_OBJS=()
+for src in vnadll_ext_*.cpp; do
+	g++ -o "${src%.cpp}.o" -c "${CXXFLAGS[@]}" "$src"
+	EXT_OBJS+=("${src%.cpp}.o")
+done
+
+# Deterministic checks of the extensions; no hardware needed.
+# `./build.sh ext_selftest` stops after running them.
+g++ -o vnadll_selftest.o -c "${CXXFLAGS[@]}" vnadll_selftest.cpp
+g++ -o vnadll_selftest.bin -std=c++11 -pthread -g vnadll_selftest.o "${EXT_OBJS[@]}" libvnadll.so
+
+LD_LIBRARY_PATH=. ./vnadll_selftest.bin
+if [ "$1" = "ext_selftest" ]; then
+	exit 0
+fi
+
+g++ -o vnadll_test.o -c "${CXXFLAGS[@]}" vnadll_test.cpp
+g++ -o vnadll_test.bin -std=c++11 -pthread -g vnadll_test.o "${EXT_OBJS[@]}" libvnadll.so
 
 LD_LIBRARY_PATH=. ./vnadll_test.bin
\ No newline at end of file
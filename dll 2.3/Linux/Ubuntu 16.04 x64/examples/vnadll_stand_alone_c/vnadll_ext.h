@@ -0,0 +1,1795 @@
+
+#ifndef __AKELA_VNA_EXT_HEADER
+#define __AKELA_VNA_EXT_HEADER
+
+#include <stddef.h>
+#include "vna_header_agg_c.h"
+
+/** \addtogroup VNA-EXT-API
+ *
+ *  \section ext-overview Host-side extensions
+ *
+ *  These functions are layered on top of the \ref VNA-C-API. They never
+ *  talk to the AVMU directly; every hardware access goes through the
+ *  regular DLL calls on the same TaskHandle. Extension state (buffers,
+ *  completion descriptors, etc.) is created lazily the first time a Task
+ *  is passed to one of these functions, and must be released with
+ *  deleteTaskExtensions() before the Task itself is deleted.
+ *
+ *  While an extension operation is in flight on a Task, the caller must not
+ *  call the blocking DLL functions on that Task from another thread.
+ *
+ */
+
+
+/** \addtogroup VNA-EXT-API
+ *  @{
+ */
+
+
+// <<<<<< CPP WRAP START
+	#ifdef __cplusplus
+		extern "C" {
+	#endif
+// CPP WRAP END >>>>>>>>
+
+
+// VNAEXT_EXPORTS should only be defined when building the extensions
+// as a shared library.
+#if defined(_MSC_VER)
+	#ifdef VNAEXT_EXPORTS
+		#define VNAEXT_API extern __declspec(dllexport)
+	#else
+		#define VNAEXT_API extern
+	#endif
+#endif
+#ifdef LINUX
+	#ifdef VNAEXT_EXPORTS
+		#define VNAEXT_API extern __attribute__((visibility("default")))
+	#else
+		#define VNAEXT_API extern
+	#endif
+#endif
+
+
+	/** \addtogroup MeasurementKind
+	 *  @brief Measurement selector for the non-blocking measurement functions.
+	 *
+	 *  @{
+	 */
+	/**
+	 * Measurement kind value type. Treat this as an opaque type.
+	 */
+	typedef int MeasurementKind;
+	VNAEXT_API MeasurementKind MEAS_UNCALIBRATED;        //!< Equivalent of measureUncalibrated()
+	VNAEXT_API MeasurementKind MEAS_2PORT_CALIBRATED;    //!< Equivalent of measure2PortCalibrated()
+	/** @}*/
+
+
+	/**
+	 * @brief Progress report passed to a \ref progress_stats_callback.
+	 */
+	typedef struct InitProgress_t
+	{
+		/** Percentage of the download, from 0 - 100 %. */
+		int percent;
+		/** Seconds since the start of the download. */
+		double elapsed_seconds;
+		/** Mean download rate so far, in percent per second. */
+		double percent_per_second;
+		/** Estimated seconds until the download completes. Negative until a rate is known. */
+		double remaining_seconds;
+	} InitProgress;
+
+	/**
+	 * @brief Method signature for the callback passed to initializeWithStats().
+	 *        Same semantics as \ref progress_callback, with download throughput
+	 *        and a completion estimate added.
+	 *
+	 * @param progress Current progress. Only valid for the duration of the call.
+	 * @param user "user data" pointer passed to initializeWithStats().
+	 * @return Continue value. Return false to cancel the download.
+	 */
+	typedef bool (*progress_stats_callback)(const InitProgress* progress, void* user);
+
+	/** \addtogroup FrequencyOrder
+	 *  @brief Point ordering modes for setFrequencyOrdering().
+	 *
+	 *  @{
+	 */
+	/**
+	 * Frequency ordering value type. Treat this as an opaque type.
+	 */
+	typedef int FrequencyOrder;
+	VNAEXT_API FrequencyOrder ORDER_AS_GIVEN;       //!< Program the points in the order given (default)
+	VNAEXT_API FrequencyOrder ORDER_GROUP_BY_BAND;  //!< Group the points per synthesizer band, lowest band first, keeping their order within a band
+	VNAEXT_API FrequencyOrder ORDER_ASCENDING;      //!< Program the points in ascending frequency order
+	/** @}*/
+
+	/** \addtogroup AdaptiveMetric
+	 *  @brief Refinement criteria for measureAdaptive().
+	 *
+	 *  @{
+	 */
+	/**
+	 * Adaptive sweep metric value type. Treat this as an opaque type.
+	 */
+	typedef int AdaptiveMetric;
+	VNAEXT_API AdaptiveMetric ADAPT_CURVATURE;    //!< Deviation of a point from the line through its neighbours, relative to its magnitude
+	VNAEXT_API AdaptiveMetric ADAPT_PHASE_SLOPE;  //!< Phase change between neighbouring points, in radians
+	VNAEXT_API AdaptiveMetric ADAPT_NOTCH_DEPTH;  //!< Log-magnitude change between neighbouring points, in dB
+	/** @}*/
+
+	/** \addtogroup TimeDomainMode
+	 *  @brief Transform modes for timeDomainTransform().
+	 *
+	 *  @{
+	 */
+	/**
+	 * Time domain mode value type. Treat this as an opaque type.
+	 */
+	typedef int TimeDomainMode;
+	VNAEXT_API TimeDomainMode TD_BANDPASS;  //!< Complex impulse response of the measured band; any evenly spaced sweep
+	VNAEXT_API TimeDomainMode TD_LOWPASS;   //!< Real impulse response; the sweep must lie on a harmonic grid (every frequency a multiple of the spacing)
+	/** @}*/
+
+	/** \addtogroup WindowType
+	 *  @brief Window functions applied before a transform.
+	 *
+	 *  @{
+	 */
+	/**
+	 * Window value type. Treat this as an opaque type.
+	 */
+	typedef int WindowType;
+	VNAEXT_API WindowType WINDOW_RECT;      //!< No windowing
+	VNAEXT_API WindowType WINDOW_HANN;      //!< Hann window
+	VNAEXT_API WindowType WINDOW_HAMMING;   //!< Hamming window
+	VNAEXT_API WindowType WINDOW_BLACKMAN;  //!< Blackman window
+	VNAEXT_API WindowType WINDOW_KAISER;    //!< Kaiser window; the shape parameter beta is taken from the config
+	/** @}*/
+
+	/** \addtogroup NetworkFormat
+	 *  @brief Two-port parameter sets for convertTwoPort().
+	 *
+	 *  Every set is passed as four ComplexData in the order of the
+	 *  measure2PortCalibrated() arguments: X11, X21, X12, X22.
+	 *
+	 *  @{
+	 */
+	/**
+	 * Network format value type. Treat this as an opaque type.
+	 */
+	typedef int NetworkFormat;
+	VNAEXT_API NetworkFormat NETWORK_S;     //!< Scattering parameters
+	VNAEXT_API NetworkFormat NETWORK_T;     //!< Scattering transfer parameters, [b1; a1] = T [a2; b2], so cascading is a matrix product
+	VNAEXT_API NetworkFormat NETWORK_ABCD;  //!< Chain (ABCD) parameters: A = X11, C = X21, B = X12, D = X22
+	/** @}*/
+
+	/** \addtogroup AverageMode
+	 *  @brief Sweep averaging modes for setAveraging().
+	 *
+	 *  @{
+	 */
+	/**
+	 * Averaging mode value type. Treat this as an opaque type.
+	 */
+	typedef int AverageMode;
+	VNAEXT_API AverageMode AVERAGE_OFF;          //!< Every measurement is a single sweep (default)
+	VNAEXT_API AverageMode AVERAGE_BLOCK;        //!< Every measurement is the mean of N back-to-back sweeps
+	VNAEXT_API AverageMode AVERAGE_EXPONENTIAL;  //!< Every measurement takes one sweep and returns the exponential moving average over about N sweeps
+	/** @}*/
+
+	/**
+	 * @brief Handle to a per-point statistics accumulator, see createStatistics().
+	 */
+	typedef struct statistics_t statistics_container;
+	typedef statistics_container* StatisticsHandle;
+
+	/**
+	 * @brief Handle to a post-processing pipeline definition, see createPipeline().
+	 */
+	typedef struct pipeline_t pipeline_container;
+	typedef pipeline_container* PipelineHandle;
+
+	/**
+	 * @brief One entry of a sweep segment table, see setSweepSegments().
+	 *        Values for frequencies are in megahertz.
+	 */
+	typedef struct SweepSegment_t
+	{
+		/** Start frequency of the segment, in MHz. */
+		double start_frequency;
+		/** Stop frequency of the segment, in MHz. */
+		double stop_frequency;
+		/** Number of linearly spaced points in the segment. */
+		unsigned int points;
+		/** Hop rate for this segment. HOP_UNDEFINED uses the Task's hop rate. */
+		HopRate hop_rate;
+		/** Attenuation for this segment. ATTEN_UNDEFINED uses the Task's attenuation. */
+		Attenuation attenuation;
+	} SweepSegment;
+
+	/**
+	 * @brief One linear span of a multi-span sweep, see utilGenerateMultiSpanSweep().
+	 */
+	typedef struct FrequencySpan_t
+	{
+		/** Start frequency of the span, in MHz. */
+		double start_frequency;
+		/** Stop frequency of the span, in MHz. */
+		double stop_frequency;
+		/** Number of linearly spaced points in the span. */
+		unsigned int points;
+	} FrequencySpan;
+
+	/**
+	 * @brief Configuration of an adaptive sweep, see measureAdaptive().
+	 */
+	typedef struct AdaptiveSweep_t
+	{
+		/** Start frequency of the sweep, in MHz. */
+		double start_frequency;
+		/** Stop frequency of the sweep, in MHz. */
+		double stop_frequency;
+		/** Number of linearly spaced points in the first, coarse pass (at least 2). */
+		unsigned int coarse_points;
+		/** Upper bound on the total number of points, over all passes. */
+		unsigned int max_points;
+		/** Maximum number of refinement passes after the coarse pass. */
+		unsigned int max_passes;
+		/** Points inserted into each interval that gets refined. */
+		unsigned int refine_points;
+		/** One of the \ref AdaptiveMetric values. */
+		AdaptiveMetric metric;
+		/** Intervals whose metric exceeds this value are refined. The unit depends on `metric`. */
+		double threshold;
+		/** Index of the measurement output analysed (0 for the first output of
+		 *  measureUncalibrated() / measure2PortCalibrated(), and so on). */
+		unsigned int output;
+	} AdaptiveSweep;
+
+	/**
+	 * @brief One sample of a continuous-wave stream, see startCWStream().
+	 */
+	typedef struct CWSample_t
+	{
+		/** Time the sample was taken, in seconds since startCWStream(). */
+		double timestamp_seconds;
+		/** Index of the zero-span sweep the sample belongs to. Samples of one block
+		 *  are contiguous; there is a short gap between consecutive blocks. */
+		unsigned int block;
+		/** In-phase value per path, in the output order of measureUncalibrated(). */
+		double I[5];
+		/** Quadrature value per path, in the output order of measureUncalibrated(). */
+		double Q[5];
+	} CWSample;
+
+	/**
+	 * @brief Timing and status of one scheduled measurement, see
+	 *        startScheduledMeasurements(). Times are in seconds since the
+	 *        scheduler was started, on the host's monotonic clock.
+	 */
+	typedef struct ScheduledResult_t
+	{
+		/** Index of the period slot the measurement was fired in. */
+		unsigned int sequence;
+		/** Start time of the slot. */
+		double scheduled_seconds;
+		/** Time the measurement call was actually issued. */
+		double actual_seconds;
+		/** Time the measurement call returned. */
+		double completed_seconds;
+		/** Slots skipped before this one because the previous measurement overran its period. */
+		unsigned int missed;
+		/** Return code of the measurement. The data is only valid if this is ERR_OK. */
+		ErrCode result;
+	} ScheduledResult;
+
+	/**
+	 * @brief Configuration of a time domain transform, see timeDomainTransform().
+	 */
+	typedef struct TimeDomainConfig_t
+	{
+		/** One of the \ref TimeDomainMode values. */
+		TimeDomainMode mode;
+		/** One of the \ref WindowType values. */
+		WindowType window;
+		/** Kaiser window beta; ignored by the other windows. */
+		double window_parameter;
+		/** First time point, in seconds. */
+		double start_time;
+		/** Last time point, in seconds. If equal to `start_time`, the output covers
+		 *  the whole alias-free range [0, 1 / frequency spacing) instead. */
+		double stop_time;
+		/** Number of output time points. More points than frequencies zero-pads the
+		 *  transform; a narrow time span with many points zooms in on it. */
+		unsigned int points;
+	} TimeDomainConfig;
+
+	/**
+	 * @brief Configuration of a time domain gate, see timeDomainGate().
+	 */
+	typedef struct GateConfig_t
+	{
+		/** Start of the gate, in seconds. */
+		double start_time;
+		/** End of the gate, in seconds. */
+		double stop_time;
+		/** Shape of the gate over [start_time, stop_time]; one of the \ref WindowType values.
+		 *  WINDOW_RECT gives a hard-edged gate. */
+		WindowType gate_window;
+		/** Kaiser beta of the gate shape; ignored by the other windows. */
+		double gate_parameter;
+		/** Window applied to the frequency data before the transform, to reduce
+		 *  the sidelobes that leak through the gate. */
+		WindowType window;
+		/** Kaiser beta of the frequency window; ignored by the other windows. */
+		double window_parameter;
+		/** If true, remove the gated span instead of keeping it (e.g. to take out a
+		 *  fixture reflection). */
+		bool notch;
+	} GateConfig;
+
+	/**
+	 * @brief Output arrays of computeDerivedQuantities() and measureDerived().
+	 *
+	 *        Every pointer is either NULL, to skip that quantity, or a
+	 *        caller-allocated array with one value per frequency point. Only the
+	 *        requested quantities are computed.
+	 */
+	typedef struct DerivedQuantities_t
+	{
+		/** Log-magnitude, 20 log10 |S|, in dB. */
+		double* log_magnitude;
+		/** Phase, unwrapped along the sweep, in degrees. */
+		double* phase;
+		/** Group delay, -d(phase) / d(omega), in seconds. */
+		double* group_delay;
+		/** Voltage standing wave ratio, (1 + |S|) / (1 - |S|); infinite for |S| >= 1. */
+		double* vswr;
+		/** Real part of the impedance Z0 (1 + S) / (1 - S), for a reflection trace, in Ohms. */
+		double* resistance;
+		/** Imaginary part of the same impedance, in Ohms. */
+		double* reactance;
+	} DerivedQuantities;
+
+	/**
+	 * @brief Configuration of slow-time Doppler processing, see startDoppler().
+	 */
+	typedef struct DopplerConfig_t
+	{
+		/** Index of the output to process, in the order of the measurement
+		 *  function's arguments. */
+		unsigned int output;
+		/** Number of consecutive sweeps per Doppler map. */
+		unsigned int sweeps;
+		/** Number of Doppler bins; a power of two of at least `sweeps`. 0 uses the
+		 *  smallest power of two that is >= `sweeps`. */
+		unsigned int doppler_points;
+		/** Slow-time window applied across the sweeps of a block; one of the
+		 *  \ref WindowType values. */
+		WindowType window;
+		/** Kaiser window beta; ignored by the other windows. */
+		double window_parameter;
+	} DopplerConfig;
+
+	/**
+	 * @brief Description of a Doppler map returned by getDopplerMap().
+	 */
+	typedef struct DopplerMapInfo_t
+	{
+		/** Number of maps completed since startDoppler(); the first one is 1. */
+		unsigned int sequence;
+		/** Number of range bins (points per sweep) in the map. */
+		unsigned int range_bins;
+		/** Number of Doppler bins per range bin. */
+		unsigned int doppler_bins;
+		/** Time of the first sweep of the block, in seconds since startDoppler(). */
+		double first_sweep_seconds;
+		/** Measured sweep rate over the block, in sweeps per second. Bin k of a
+		 *  range bin is at Doppler frequency (k - doppler_bins / 2) * sweep_rate / doppler_bins.
+		 *  0 if the block has a single sweep. */
+		double sweep_rate;
+		/** Blocks dropped since the previous getDopplerMap() call, because the
+		 *  block before them was still being processed. */
+		unsigned int dropped;
+	} DopplerMapInfo;
+
+	/**
+	 * @brief Predicted cost of a sweep, see estimateSweep().
+	 *
+	 *        The DLL does not publish the AVMU program or data formats, so the
+	 *        capacity and byte figures follow a simple model: one program word per
+	 *        point, 4 bytes per program word, and I and Q as two 32-bit values per
+	 *        path per point. Treat them as planning figures, not exact counts.
+	 */
+	typedef struct SweepEstimate_t
+	{
+		/** Number of points in the sweep. */
+		unsigned int points;
+		/** Number of hardware programs the sweep needs (see setSegmentedFrequencies()). */
+		unsigned int programs;
+		/** Program words used by the largest program. */
+		unsigned int program_words_used;
+		/** Program words available on the unit (`HardwareDetails.maximum_points`). */
+		unsigned int program_words_available;
+		/** Synthesizer band transitions in programmed order. */
+		unsigned int band_switches;
+		/** Point rate of the hop rate used for the estimate. */
+		double points_per_second;
+		/** Time the hardware spends stepping through the points, in seconds. Host,
+		 *  network and reprogramming overhead are not included. */
+		double sweep_seconds;
+		/** Size of the frequency program, in bytes. */
+		double program_bytes;
+		/** Measurement data returned per sweep, in bytes. */
+		double data_bytes;
+		/** Total traffic per measurement, in bytes. This includes `program_bytes`
+		 *  when the sweep needs more than one program, since every measurement
+		 *  then downloads every program again. */
+		double bytes_on_wire;
+	} SweepEstimate;
+
+	/**
+	 * @brief Releases the extension state associated with Task `t`. If a
+	 *        non-blocking measurement is still in flight, this waits for the
+	 *        underlying DLL call to return first.
+	 *
+	 *        This must be called before deleteTask(), otherwise the extension
+	 *        state will leak.
+	 *
+	 * @param t Handle for the current task
+	 */
+	VNAEXT_API void deleteTaskExtensions(TaskHandle t);
+
+	/**
+	 * @brief Starts a measurement on Task `t` and returns immediately. The
+	 *        measurement itself runs on the library worker pool, so no thread
+	 *        per unit is required in the calling application.
+	 *
+	 *        Completion is signalled through the descriptor returned by
+	 *        getCompletionFd(), and the result is collected with
+	 *        reapMeasurement(). Only one measurement may be outstanding per
+	 *        Task; it must be reaped before another one is submitted.
+	 *
+	 *        The number of points is latched at submission time, so the
+	 *        buffers passed to reapMeasurement() must hold at least
+	 *        getSegmentedNumberOfFrequencies() values. If a segmented sweep is
+	 *        configured (see setSegmentedFrequencies()), the whole sweep is
+	 *        measured.
+	 *
+	 * @param t Handle for the current task
+	 * @param kind One of the \ref MeasurementKind values.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if the measurement was queued
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_STARTED state, or if a
+	 *          previous measurement has not yet been reaped
+	 *        - ERR_WRONG_PROGRAM_TYPE if `kind` is not a \ref MeasurementKind value
+	 *        - ERR_BAD_CAL if `kind` is MEAS_2PORT_CALIBRATED and `isCalibrationComplete() == false`
+	 *          (unless lazy factory calibration is enabled, see setLazyFactoryCalibration())
+	 */
+	VNAEXT_API ErrCode submitMeasurement(TaskHandle t, const MeasurementKind kind);
+
+	/**
+	 * @brief Cancels the measurement submitted on Task `t` with a bounded latency.
+	 *
+	 *        interruptMeasurement() only returns once the interrupt has been
+	 *        requested; the blocked measurement function can keep waiting on its
+	 *        socket for a while after that. This function instead completes the
+	 *        submitted measurement immediately: before it returns, the completion
+	 *        descriptor is readable and reapMeasurement() yields ERR_INTERRUPTED.
+	 *
+	 *        A segmented sweep (see setSegmentedFrequencies()) is stopped before
+	 *        its next segment, also when the cancel arrives while a segment is
+	 *        being programmed.
+	 *
+	 *        The interrupted DLL call is left to drain on the worker pool. A
+	 *        measurement submitted in the meantime is accepted and starts as
+	 *        soon as that call has returned. deleteTaskExtensions() also waits
+	 *        for it.
+	 *
+	 * @param t Handle for the current task
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if the measurement was cancelled
+	 *        - ERR_WRONG_STATE if there is no outstanding measurement on `t`, or
+	 *          it has already completed
+	 *        - Otherwise, the error of interruptMeasurement(). The measurement is
+	 *          then still outstanding and completes as usual, with ERR_INTERRUPTED
+	 *          if it had another DLL measurement call left to make.
+	 */
+	VNAEXT_API ErrCode cancelMeasurement(TaskHandle t);
+
+	/**
+	 * @brief Returns a file descriptor that becomes readable when the measurement
+	 *        submitted on Task `t` completes. The descriptor is owned by the
+	 *        library, stays valid until deleteTaskExtensions(), and can be added
+	 *        to an epoll/select/asio loop. It is an eventfd on Linux.
+	 *
+	 *        The descriptor is drained by reapMeasurement(); the caller should not
+	 *        read from it directly.
+	 *
+	 * @param t Handle for the current task
+	 * @return File descriptor, or -1 if `t` is NULL or the platform has no
+	 *         eventfd support.
+	 */
+	VNAEXT_API int getCompletionFd(TaskHandle t);
+
+	/**
+	 * @brief Query if the measurement submitted on Task `t` has completed and
+	 *        is ready to be reaped.
+	 *
+	 * @param t Handle for the current task
+	 * @return true if reapMeasurement() will return the measurement result,
+	 *         false if nothing is outstanding or the sweep is still in flight.
+	 */
+	VNAEXT_API bool isMeasurementReady(TaskHandle t);
+
+	/**
+	 * @brief Collects the result of a measurement started with submitMeasurement().
+	 *        This never blocks. The ComplexData parameters are caller-allocated,
+	 *        as for the blocking measurement functions, and it is safe to supply
+	 *        null pointers for data that is not needed.
+	 *
+	 *        For MEAS_UNCALIBRATED the parameters receive T1R1, T1R2, T2R1, T2R2 and Ref.
+	 *        For MEAS_2PORT_CALIBRATED they receive S11, S21, S12 and S22; `out4` is unused.
+	 *
+	 * @param t Handle for the current task
+	 * @return Call status - Possible return values:
+	 *        - ERR_WRONG_STATE if nothing was submitted, or the sweep is still in flight
+	 *        - Otherwise, the return code of the underlying measurement function
+	 *          (ERR_OK, ERR_NO_RESPONSE, ERR_INTERRUPTED, etc.)
+	 */
+	VNAEXT_API ErrCode reapMeasurement(TaskHandle t,
+	                                   ComplexData out0, ComplexData out1,
+	                                   ComplexData out2, ComplexData out3,
+	                                   ComplexData out4);
+
+
+	/**
+	 * @brief Same as initialize(), but the callback also receives the download
+	 *        throughput and an estimate of the remaining time, so a front-end
+	 *        can show something better than the generic "up to 30 seconds"
+	 *        warning.
+	 *
+	 * @param t Handle for the current task
+	 * @param callback User-provided \ref progress_stats_callback, or NULL.
+	 * @param user user-data provided to the callback function.
+	 * @return Same return values as initialize().
+	 */
+	VNAEXT_API ErrCode initializeWithStats(TaskHandle t, progress_stats_callback callback, void* user);
+
+	/**
+	 * @brief Starts initialize() for Task `t` on the library worker pool and
+	 *        returns immediately. Completion is signalled through the descriptor
+	 *        returned by getCompletionFd(), and the result is collected with
+	 *        reapInitialize().
+	 *
+	 *        `callback` is called from a worker thread, with the same semantics as
+	 *        for initialize(). Returning false from it cancels the download.
+	 *
+	 * @param t Handle for the current task
+	 * @param callback User-provided \ref progress_callback, or NULL.
+	 * @param user user-data provided to the callback function.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if the initialization was queued
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_UNINITIALIZED state, or
+	 *          another extension operation is outstanding on it
+	 */
+	VNAEXT_API ErrCode initializeAsync(TaskHandle t, progress_callback callback, void* user);
+
+	/**
+	 * @brief Collects the result of an initializeAsync() call. This never blocks.
+	 *
+	 * @param t Handle for the current task
+	 * @return Call status - Possible return values:
+	 *        - ERR_WRONG_STATE if nothing was started, or the initialization is still running
+	 *        - Otherwise, the return code of initialize()
+	 */
+	VNAEXT_API ErrCode reapInitialize(TaskHandle t);
+
+	/**
+	 * @brief Initializes several Tasks concurrently, and blocks until all of them
+	 *        are done. The PROM/calibration downloads of the different units
+	 *        overlap, so the call takes about as long as the slowest unit.
+	 *
+	 *        Progress is reported as the mean of the progress of every unit.
+	 *        The callback is called from the calling thread, and only when the
+	 *        aggregate percentage changes. If it returns false, every download
+	 *        that is still running is cancelled.
+	 *
+	 * @param tasks Array of `N` task handles. Each must be in the TASK_UNINITIALIZED state.
+	 * @param N Length of the `tasks` array.
+	 * @param results Optional caller-allocated array of `N` values, receiving the
+	 *                return code of initialize() for each task. Set to NULL if unused.
+	 * @param callback User-provided \ref progress_callback, or NULL.
+	 * @param user user-data provided to the callback function.
+	 * @return ERR_OK if every task was initialized, otherwise the first failing
+	 *         return code in `tasks` order (ERR_BAD_HANDLE if any handle is NULL).
+	 */
+	VNAEXT_API ErrCode initializeMany(TaskHandle* tasks, const unsigned int N, ErrCode* results,
+	                                  progress_callback callback, void* user);
+
+
+	/**
+	 * @brief Defers loading the factory calibration until the first calibrated
+	 *        measurement made through the extension functions (e.g.
+	 *        submitMeasurement() with MEAS_2PORT_CALIBRATED).
+	 *
+	 *        When enabled and no calibration is present, the factory calibration
+	 *        is imported at that point and immediately restricted to the points
+	 *        bracketing the configured sweep (see restrictCalibrationToSweep()).
+	 *        If the sweep is later changed to extend beyond the range kept, the
+	 *        factory calibration is imported and restricted again. A calibration
+	 *        supplied by the caller (importCalibration() or measureCalibrationStep())
+	 *        is never replaced, also when it replaced a factory calibration
+	 *        loaded earlier. A calibration counts as the caller's once its number
+	 *        of points or first or last frequency differ from what was loaded.
+	 *
+	 *        Note that the calibration download from the unit PROM still happens
+	 *        in initialize(); this controls when it is imported into the Task and
+	 *        how much of it is kept.
+	 *
+	 * @param t Handle for the current task
+	 * @param enable Enable lazy loading.
+	 * @return Call status - Possible return values:
+	 *          - ERR_OK if all went according to plan
+	 *          - ERR_BAD_HANDLE if `t` is NULL
+	 */
+	VNAEXT_API ErrCode setLazyFactoryCalibration(TaskHandle t, const bool enable);
+
+	/**
+	 * @brief Discards the calibration points that are not needed to interpolate
+	 *        the configured sweep. Only the calibration points that bracket the
+	 *        lowest and highest sweep frequency (and everything between them)
+	 *        are kept, and re-imported with importCalibration().
+	 *
+	 *        Memory use and the cost of re-interpolating the calibration after a
+	 *        sweep change then scale with the sweep span rather than with the
+	 *        full range of the unit.
+	 *
+	 * @param t Handle for the current task
+	 * @return Call status - Possible return values:
+	 *          - ERR_OK if all went according to plan
+	 *          - ERR_BAD_HANDLE if `t` is NULL
+	 *          - ERR_BAD_CAL if `isCalibrationComplete() == false`
+	 *          - ERR_MISSING_FREQS if no sweep is configured
+	 *          - ERR_WRONG_STATE if the Task is not in the TASK_STOPPED or TASK_STARTED state
+	 */
+	VNAEXT_API ErrCode restrictCalibrationToSweep(TaskHandle t);
+
+
+	/**
+	 * @brief Set a frequency list of arbitrary length. Lists longer than
+	 *        `HardwareDetails.maximum_points` are split into hardware-sized
+	 *        segments; the measurement functions of this extension then program
+	 *        and sweep each segment in turn, and stitch the results (calibrated or
+	 *        not) into one sweep in the order of `freqs`.
+	 *
+	 *        Each segment is checked with setFrequencies(), so frequencies are
+	 *        snapped to generateable values exactly as for a single program. Use
+	 *        getSegmentedFrequencies() to get the actual frequency list. On return
+	 *        the first segment is set on the Task, so start() programs it.
+	 *
+	 *        Consecutive sweeps run the segments in alternating order, so that
+	 *        the segment programmed at the end of one sweep is reused at the
+	 *        start of the next. If a segment still overflows the program memory
+	 *        at start() (ERR_PROG_OVERFLOW), it is split in two and the sweep is
+	 *        retried.
+	 *
+	 *        While a segmented sweep is set, do not call setFrequencies() on the
+	 *        Task directly; use clearSegmentedFrequencies() first.
+	 *
+	 * @param t Handle for the current task
+	 * @param freqs array of frequencies to sample, in MHz
+	 * @param N Length of `freqs` array.
+	 * @return Call status - Possible return values:
+	 *       - ERR_OK if all went according to plan
+	 *       - ERR_BAD_HANDLE if `t` is NULL
+	 *       - ERR_MISSING_FREQS if `N` is 0
+	 *       - ERR_WRONG_STATE if the Task is not in the TASK_STOPPED state, or an extension
+	 *         measurement is in flight
+	 *       - ERR_FREQ_OUT_OF_BOUNDS if a frequency is beyond the allowed min/max
+	 */
+	VNAEXT_API ErrCode setSegmentedFrequencies(TaskHandle t, const double* freqs, const unsigned int N);
+
+	/**
+	 * @brief Select how setSegmentedFrequencies() orders points in the hardware
+	 *        program. Arbitrary frequency lists can bounce between the synthesizer
+	 *        bands (see `HardwareDetails.band_boundaries`) and pay the band
+	 *        settling time on every switch; ORDER_GROUP_BY_BAND and ORDER_ASCENDING
+	 *        program the points so that each band is visited once.
+	 *
+	 *        The reordering is invisible to the caller: the measurement functions
+	 *        of this extension put every point back at its position in the list
+	 *        passed to setSegmentedFrequencies(), using an index map computed when
+	 *        the list is set. getSegmentedFrequencies() also uses the caller's order.
+	 *
+	 *        Takes effect at the next setSegmentedFrequencies() call.
+	 *
+	 * @param t Handle for the current task
+	 * @param ordering One of the \ref FrequencyOrder values.
+	 * @return Call status - Possible return values:
+	 *       - ERR_OK if all went according to plan
+	 *       - ERR_BAD_HANDLE if `t` is NULL
+	 *       - ERR_WRONG_PROGRAM_TYPE if `ordering` is not a \ref FrequencyOrder value
+	 */
+	VNAEXT_API ErrCode setFrequencyOrdering(TaskHandle t, const FrequencyOrder ordering);
+
+	/**
+	 * @brief Set a sweep from a segment table, where each segment has its own
+	 *        linear frequency range, number of points, hop rate and attenuation.
+	 *        Dwell time can then be spent only in the bands that need it.
+	 *
+	 *        The segment end points are adjusted as documented in
+	 *        utilFixLinearSweepLimits(). A segment may have more than
+	 *        `HardwareDetails.maximum_points` points: it is then adjusted and
+	 *        programmed in blocks of `maximum_points`, each equally spaced over its
+	 *        share of the segment, and still ends at the segment's stop frequency. Consecutive segments that share a hop rate
+	 *        and attenuation are packed into the same hardware program (up to
+	 *        `HardwareDetails.maximum_points`); the others are programmed and swept
+	 *        in turn, exactly as for setSegmentedFrequencies(), and the results are
+	 *        returned as one sweep in table order.
+	 *
+	 *        The hop rate and attenuation of the Task are changed as the segments
+	 *        are programmed. Segments that leave them undefined take the Task
+	 *        values at the time of this call. If the Task has no attenuation set
+	 *        either, those segments keep whatever attenuation was last programmed.
+	 *
+	 * @param t Handle for the current task
+	 * @param segments Array of `N` \ref SweepSegment entries.
+	 * @param N Length of the `segments` array.
+	 * @return Call status - Possible return values:
+	 *       - ERR_OK if all went according to plan
+	 *       - ERR_BAD_HANDLE if `t` is NULL
+	 *       - ERR_MISSING_FREQS if the table is empty
+	 *       - ERR_MISSING_HOP if a segment has no hop rate and none is set on the Task
+	 *       - ERR_WRONG_STATE if the Task is not in the TASK_STOPPED state, or an extension
+	 *         measurement is in flight
+	 *       - ERR_FREQ_OUT_OF_BOUNDS if a frequency is beyond the allowed min/max
+	 *       - ERR_BAD_HOP / ERR_BAD_ATTEN if a segment setting is invalid
+	 */
+	VNAEXT_API ErrCode setSweepSegments(TaskHandle t, const SweepSegment* segments, const unsigned int N);
+
+	/**
+	 * @brief Set a power sweep: the frequency list `freqs` is measured once per
+	 *        attenuation step in `attens`. The extension measurement functions
+	 *        then return `M * N` points laid out as an [attenuation][frequency]
+	 *        block, i.e. point `m * N + n` is frequency `n` at attenuation `attens[m]`.
+	 *        Use a single frequency for a CW power sweep.
+	 *
+	 *        The AVMU applies one attenuation to a whole program, so the steps
+	 *        cannot share a hardware program. Each step is programmed and swept in
+	 *        turn as a segment (see setSegmentedFrequencies()), and the whole block
+	 *        comes back from a single measurement call. Consecutive power sweeps
+	 *        run the steps in alternating order, so the step programmed last is
+	 *        reused without another upload.
+	 *
+	 * @param t Handle for the current task
+	 * @param freqs Array of `N` frequencies, in MHz.
+	 * @param N Length of the `freqs` array.
+	 * @param attens Array of `M` \ref Attenuation values, in measurement order.
+	 * @param M Length of the `attens` array.
+	 * @return Call status - Possible return values:
+	 *       - ERR_OK if all went according to plan
+	 *       - ERR_BAD_HANDLE if `t` is NULL
+	 *       - ERR_MISSING_FREQS if `freqs` is NULL or `N` is 0
+	 *       - ERR_MISSING_ATTEN if `attens` is NULL or `M` is 0
+	 *       - ERR_BAD_ATTEN if a step is ATTEN_UNDEFINED or otherwise invalid
+	 *       - ERR_WRONG_STATE if the Task is not in the TASK_STOPPED state, or an extension
+	 *         measurement is in flight
+	 *       - ERR_FREQ_OUT_OF_BOUNDS if a frequency is beyond the allowed min/max
+	 */
+	VNAEXT_API ErrCode setPowerSweep(TaskHandle t, const double* freqs, const unsigned int N,
+	                                 const Attenuation* attens, const unsigned int M);
+
+	/**
+	 * @brief Remove the segmented sweep set by setSegmentedFrequencies(). The
+	 *        Task keeps whatever frequencies were last programmed.
+	 *
+	 * @param t Handle for the current task
+	 * @return Call status - Possible return values:
+	 *       - ERR_OK if all went according to plan
+	 *       - ERR_BAD_HANDLE if `t` is NULL
+	 *       - ERR_WRONG_STATE if an extension measurement is in flight
+	 */
+	VNAEXT_API ErrCode clearSegmentedFrequencies(TaskHandle t);
+
+	/**
+	 * @brief Get the number of frequency points measured by the extension
+	 *        measurement functions: the length of the segmented sweep if one is
+	 *        set, getNumberOfFrequencies() otherwise.
+	 *
+	 * @param t Handle for the current task
+	 * @return Number of frequency points.
+	 */
+	VNAEXT_API unsigned int getSegmentedNumberOfFrequencies(TaskHandle t);
+
+	/**
+	 * @brief Get the actual frequencies (MHz) measured by the extension
+	 *        measurement functions, in output order.
+	 *
+	 * @param t Handle for the current task
+	 * @param freqs Caller-allocated array of at least getSegmentedNumberOfFrequencies() values.
+	 * @param freqs_sz The size of the freqs array.
+	 * @return ERR_OK or ERR_BAD_HANDLE depending on handle validity
+	 */
+	VNAEXT_API ErrCode getSegmentedFrequencies(TaskHandle t, double* freqs, const unsigned int freqs_sz);
+
+	/**
+	 * @brief Blocking counterpart of submitMeasurement() / reapMeasurement().
+	 *        Measures the whole (possibly segmented) sweep. The output layout is
+	 *        the same as for reapMeasurement(), and the buffers must hold at least
+	 *        getSegmentedNumberOfFrequencies() values. Null pointers are allowed
+	 *        for either array of any output; outputs the DLL cannot take as given
+	 *        are measured into internal buffers and the requested arrays copied out.
+	 *
+	 * @param t Handle for the current task
+	 * @param kind One of the \ref MeasurementKind values.
+	 * @return Call status - Possible return values:
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_STARTED state, or a
+	 *          submitted measurement has not been reaped yet
+	 *        - ERR_WRONG_PROGRAM_TYPE if `kind` is not a \ref MeasurementKind value
+	 *        - Otherwise, the return codes of stop(), setFrequencies(), start() and the
+	 *          underlying measurement function
+	 */
+	VNAEXT_API ErrCode measureSegmented(TaskHandle t, const MeasurementKind kind,
+	                                    ComplexData out0, ComplexData out1,
+	                                    ComplexData out2, ComplexData out3,
+	                                    ComplexData out4);
+
+
+	/**
+	 * @brief Predict the duration, program usage and network traffic of a sweep
+	 *        over `freqs`, without touching the hardware or changing any Task
+	 *        setting. Band switches are counted in the order setFrequencyOrdering()
+	 *        currently selects.
+	 *
+	 *        The Task must have been initialized, since the estimate needs the
+	 *        hardware details of the unit.
+	 *
+	 * @param t Handle for the current task
+	 * @param freqs Array of `N` frequencies, in MHz.
+	 * @param N Number of points.
+	 * @param hop Hop rate to estimate for. HOP_UNDEFINED uses the Task's hop rate.
+	 * @param atten Attenuation to estimate for. Attenuation affects neither timing nor
+	 *        program size on current hardware; it is accepted for symmetry with
+	 *        setSweepSegments().
+	 * @param paths Number of RF paths transferred per point: 5 for
+	 *        measureUncalibrated(), or fewer if only some outputs are needed.
+	 * @param estimate Filled with the estimate on success.
+	 * @return Call status - Possible return values:
+	 *       - ERR_OK if all went according to plan
+	 *       - ERR_BAD_HANDLE if `t` is NULL
+	 *       - ERR_WRONG_PROGRAM_TYPE if `estimate` is NULL
+	 *       - ERR_MISSING_FREQS if `freqs` is NULL or `N` is 0
+	 *       - ERR_BAD_PATH if `paths` is 0 or more than 5
+	 *       - ERR_WRONG_STATE if the Task has not been initialized
+	 *       - ERR_MISSING_HOP if no hop rate is given or set on the Task
+	 *       - ERR_FREQ_OUT_OF_BOUNDS if a frequency is beyond the allowed min/max
+	 */
+	VNAEXT_API ErrCode estimateSweep(TaskHandle t, const double* freqs, const unsigned int N,
+	                                 HopRate hop, Attenuation atten, const unsigned int paths,
+	                                 SweepEstimate* estimate);
+
+	/**
+	 * @brief Batch version of utilNearestLegalFreq(): adjusts each of the `N`
+	 *        frequencies in `freqs`, in MHz, to the nearest one the hardware can
+	 *        generate.
+	 *
+	 *        The first call on a unit probes utilNearestLegalFreq() to learn the
+	 *        step and offset of the synthesizer lattice in each band, and checks the
+	 *        model against the DLL before using it. After that, snapping one point
+	 *        costs a few arithmetic operations. Points within one step of a band
+	 *        edge, and bands that could not be modelled, are still passed to
+	 *        utilNearestLegalFreq(). initializeWithStats(), initializeAsync() and
+	 *        initializeMany() probe the lattice as part of initialization. The
+	 *        lattice is probed again if the Task connects to a different unit.
+	 *
+	 * @param t Handle for the current task
+	 * @param freqs Array of `N` requested frequencies, modified in place.
+	 * @param N Number of frequencies.
+	 * @return Call status - Possible return values:
+	 *       - ERR_OK if all went according to plan
+	 *       - ERR_BAD_HANDLE if `t` is NULL
+	 *       - ERR_MISSING_FREQS if `freqs` is NULL
+	 *       - ERR_WRONG_STATE if the Task is in the TASK_UNINITIALIZED state
+	 *       - ERR_FREQ_OUT_OF_BOUNDS if a frequency is beyond the allowed min/max. Such
+	 *         frequencies are left unchanged; all other entries are still adjusted.
+	 */
+	VNAEXT_API ErrCode utilNearestLegalFreqs(TaskHandle t, double* freqs, const unsigned int N);
+
+	/**
+	 * @brief Generates a logarithmically spaced sweep of `N` points from `startFreq`
+	 *        to `endFreq` and sets it with setSegmentedFrequencies(), so `N` may
+	 *        exceed `HardwareDetails.maximum_points`.
+	 *
+	 *        Every point is snapped to the nearest generateable frequency (see
+	 *        utilNearestLegalFreqs()), and points that snap to the same frequency
+	 *        are merged, so the sweep can have fewer than `N` points where the
+	 *        log spacing is finer than the synthesizer step. Use
+	 *        getSegmentedNumberOfFrequencies() and getSegmentedFrequencies() to get
+	 *        the resulting list. Since it changes the frequencies this function is
+	 *        only available in the TASK_STOPPED state.
+	 *
+	 * @param t Handle for the current task
+	 * @param startFreq Start frequency of sweep in Mhz
+	 * @param endFreq End frequency of sweep in Mhz
+	 * @param N Number of points to generate.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_MISSING_FREQS if `N` is 0
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_STOPPED state
+	 *        - ERR_FREQ_OUT_OF_BOUNDS if one of the bounds is beyond the allowed min/max
+	 */
+	VNAEXT_API ErrCode utilGenerateLogSweep(TaskHandle t, const double startFreq, const double endFreq, const unsigned int N);
+
+	/**
+	 * @brief Generates a sweep covering several linear spans and sets it with
+	 *        setSegmentedFrequencies(). The points of all spans are snapped to
+	 *        generateable frequencies, sorted in ascending order and deduplicated,
+	 *        so overlapping spans are merged. See utilGenerateLogSweep() for how to
+	 *        get the resulting list.
+	 *
+	 * @param t Handle for the current task
+	 * @param spans Array of `M` \ref FrequencySpan entries.
+	 * @param M Number of spans.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_MISSING_FREQS if `spans` is NULL, `M` is 0 or no span has any points
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_STOPPED state
+	 *        - ERR_FREQ_OUT_OF_BOUNDS if a span reaches beyond the allowed min/max
+	 */
+	VNAEXT_API ErrCode utilGenerateMultiSpanSweep(TaskHandle t, const FrequencySpan* spans, const unsigned int M);
+
+	/**
+	 * @brief Generates a sweep of `N` points over `span` around `centerFreq`, with
+	 *        `zoomN` extra points over the narrower `zoomSpan` around the same
+	 *        center, and sets it with setSegmentedFrequencies(). Points are
+	 *        snapped, sorted and deduplicated as for utilGenerateMultiSpanSweep().
+	 *
+	 * @param t Handle for the current task
+	 * @param centerFreq Center frequency in Mhz
+	 * @param span Width of the full sweep in Mhz
+	 * @param N Number of points over the full sweep.
+	 * @param zoomSpan Width of the zoomed region in Mhz
+	 * @param zoomN Number of points over the zoomed region.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_MISSING_FREQS if both `N` and `zoomN` are 0
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_STOPPED state
+	 *        - ERR_FREQ_OUT_OF_BOUNDS if a span is negative or reaches beyond the allowed min/max
+	 */
+	VNAEXT_API ErrCode utilGenerateZoomSweep(TaskHandle t, const double centerFreq,
+	                                         const double span, const unsigned int N,
+	                                         const double zoomSpan, const unsigned int zoomN);
+
+	/**
+	 * @brief Measure a sweep that concentrates its points where the response
+	 *        changes quickly.
+	 *
+	 *        A coarse linear pass over the configured span is measured first. The
+	 *        interval between each pair of neighbouring points is then scored on
+	 *        output `config->output` with `config->metric`. Every interval scoring
+	 *        above `config->threshold` gets `config->refine_points` new points,
+	 *        highest scores first, until `config->max_points` is reached. Only the
+	 *        new points are measured in each follow-up pass, using the segmented
+	 *        sweep machinery (see setSegmentedFrequencies()). Refinement stops after
+	 *        `config->max_passes` passes, or when no interval exceeds the threshold
+	 *        or can be split any further on the synthesizer lattice.
+	 *
+	 *        On return the complete point list, sorted by frequency, is set as the
+	 *        segmented sweep of the Task. measureSegmented() and submitMeasurement()
+	 *        therefore repeat the adaptive sweep without analysing it again.
+	 *
+	 *        The passes are measured with averaging and ratio mode applied, and
+	 *        scored on that data. Background subtraction (see setBaseline()) and
+	 *        de-embedding (see setDeembedding()) are applied once to the complete
+	 *        sweep, which is also the only sweep added to attached statistics and
+	 *        Doppler processing.
+	 *
+	 *        The output buffers and `freqs` must hold at least `config->max_points`
+	 *        values. Null pointers are allowed. For MEAS_2PORT_CALIBRATED, `out4` is
+	 *        not written.
+	 *
+	 * @param t Handle for the current task
+	 * @param kind One of the \ref MeasurementKind values.
+	 * @param config Adaptive sweep configuration.
+	 * @param freqs Caller-allocated array that receives the measured frequencies, in MHz.
+	 * @param N Receives the number of points measured.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `kind` or `config->metric` is invalid, `config` or
+	 *          `N` is NULL, or `config->refine_points` is 0
+	 *        - ERR_BAD_PATH if `config->output` is not an output of `kind`
+	 *        - ERR_MISSING_FREQS if `config->coarse_points` is less than 2 or more than
+	 *          `config->max_points`, or if the complete sweep does not match a fixed
+	 *          background or the de-embedding fixtures
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_STARTED state, an extension
+	 *          measurement is in flight, or a pipeline is attached (see attachPipeline())
+	 *        - Otherwise, the return codes of stop(), setFrequencies(), start() and the
+	 *          underlying measurement function
+	 */
+	VNAEXT_API ErrCode measureAdaptive(TaskHandle t, const MeasurementKind kind, const AdaptiveSweep* config,
+	                                   double* freqs, unsigned int* N,
+	                                   ComplexData out0, ComplexData out1,
+	                                   ComplexData out2, ComplexData out3,
+	                                   ComplexData out4);
+
+	/**
+	 * @brief Start streaming uncalibrated I/Q samples at a single frequency.
+	 *
+	 *        The Task is programmed with a zero-span sweep of `block_points`
+	 *        points at `freq` (snapped to the nearest generateable frequency) and
+	 *        started. A background thread then measures it back to back and
+	 *        appends every sample to a ring of `ring_samples` entries, which the
+	 *        caller drains with readCWStream(). When the ring is full the oldest
+	 *        samples are overwritten. Descriptor returned by getCompletionFd()
+	 *        becomes readable whenever new samples are available.
+	 *
+	 *        The DLL does not return the hardware sweep timer, so timestamps are
+	 *        taken on the host: each block is stamped when its measurement call
+	 *        returns, and the samples inside it are spaced at the hop rate. Between
+	 *        blocks there is a gap of one measurement round trip; the `block`
+	 *        field of \ref CWSample identifies where these gaps are. Larger blocks
+	 *        make the gaps rarer, at the cost of latency.
+	 *
+	 *        Any segmented sweep set on the Task is cleared. While the stream runs,
+	 *        the other extension measurement functions return ERR_WRONG_STATE.
+	 *
+	 *        A block that fails with ERR_NO_RESPONSE or ERR_BYTES (e.g. a lost
+	 *        packet) is dropped and retried after a short pause, up to 3 times in
+	 *        a row. Any other error, or a fourth consecutive failure, stops the
+	 *        stream; the descriptor becomes readable, and readCWStream() and
+	 *        stopCWStream() report the error.
+	 *
+	 * @param t Handle for the current task
+	 * @param freq CW frequency in Mhz
+	 * @param block_points Points per zero-span sweep. 0 uses `HardwareDetails.maximum_points`.
+	 * @param ring_samples Capacity of the sample ring.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `ring_samples` is 0
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_STOPPED state, or an extension
+	 *          measurement is in flight
+	 *        - ERR_TOO_MANY_POINTS if `block_points` is larger than the maximum allowed
+	 *        - ERR_MISSING_HOP if the hop rate has not been set
+	 *        - Otherwise, the return codes of utilNearestLegalFreq(), setFrequencies() and start()
+	 */
+	VNAEXT_API ErrCode startCWStream(TaskHandle t, const double freq, const unsigned int block_points,
+	                                 const unsigned int ring_samples);
+
+	/**
+	 * @brief Stop a stream started by startCWStream(). The block being measured is
+	 *        interrupted and discarded. Samples already in the ring can still be
+	 *        read with readCWStream(). The Task stays in the TASK_STARTED state.
+	 *
+	 *        deleteTaskExtensions() also stops a running stream.
+	 *
+	 * @param t Handle for the current task
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_WRONG_STATE if no stream is running
+	 *        - The error that stopped the stream, if it stopped on its own. The
+	 *          error is only reported once.
+	 */
+	VNAEXT_API ErrCode stopCWStream(TaskHandle t);
+
+	/**
+	 * @brief Take up to `max_samples` of the oldest samples from the stream ring.
+	 *        Does not block.
+	 *
+	 * @param t Handle for the current task
+	 * @param samples Caller-allocated array of at least `max_samples` entries.
+	 * @param max_samples Size of `samples`.
+	 * @param count Receives the number of samples copied.
+	 * @param dropped If not NULL, receives the number of samples overwritten
+	 *        because the ring was full since the previous call.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_WRONG_PROGRAM_TYPE if `samples` or `count` is NULL
+	 *        - ERR_WRONG_STATE if no stream was started on the Task
+	 *        - The error that stopped the stream, once the ring is empty and the
+	 *          stream stopped because of it (see startCWStream())
+	 */
+	VNAEXT_API ErrCode readCWStream(TaskHandle t, CWSample* samples, const unsigned int max_samples,
+	                                unsigned int* count, unsigned int* dropped);
+
+	/**
+	 * @brief Measure the current (possibly segmented) sweep at a fixed period in
+	 *        the background, until stopScheduledMeasurements() is called.
+	 *
+	 *        A library thread waits for each period boundary with an absolute
+	 *        deadline on the monotonic clock, so jitter does not accumulate, and
+	 *        then issues the measurement. Results are queued with their scheduled
+	 *        and actual start times (see \ref ScheduledResult) and are collected
+	 *        with reapScheduledMeasurement(). The descriptor returned by
+	 *        getCompletionFd() becomes readable while results are queued. When the
+	 *        queue is full the oldest result is overwritten. If a measurement takes
+	 *        longer than the period, the slots it overlaps are skipped and counted
+	 *        in `missed`, so measurements never run back to back to catch up.
+	 *
+	 *        The DLL does not expose the hardware sweep timer, so the cadence is
+	 *        kept by the host. The DLL round trip is part of each measurement, but
+	 *        it adds no drift to later slots.
+	 *
+	 *        While the scheduler runs, the other extension measurement functions
+	 *        return ERR_WRONG_STATE. deleteTaskExtensions() also stops it.
+	 *
+	 * @param t Handle for the current task
+	 * @param kind One of the \ref MeasurementKind values.
+	 * @param period_seconds Measurement period, in seconds.
+	 * @param queue_depth Number of results kept until reaped.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `kind` is not a \ref MeasurementKind value, or
+	 *          `period_seconds` or `queue_depth` is not positive
+	 *        - ERR_WRONG_STATE if the Task is not in the TASK_STARTED state, or an extension
+	 *          measurement is in flight
+	 *        - ERR_BAD_CAL if `kind` is MEAS_2PORT_CALIBRATED and the calibration is missing
+	 */
+	VNAEXT_API ErrCode startScheduledMeasurements(TaskHandle t, const MeasurementKind kind,
+	                                              const double period_seconds,
+	                                              const unsigned int queue_depth);
+
+	/**
+	 * @brief Stop the scheduler started by startScheduledMeasurements(). A
+	 *        measurement in progress is interrupted and discarded. Queued results
+	 *        can still be reaped.
+	 *
+	 * @param t Handle for the current task
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_WRONG_STATE if the scheduler is not running
+	 */
+	VNAEXT_API ErrCode stopScheduledMeasurements(TaskHandle t);
+
+	/**
+	 * @brief Take the oldest queued result of the scheduler. Does not block. The
+	 *        output layout is the same as for reapMeasurement(), and the buffers
+	 *        must hold at least getSegmentedNumberOfFrequencies() values (as of the
+	 *        time the scheduler was started). Null pointers are allowed.
+	 *
+	 * @param t Handle for the current task
+	 * @param info If not NULL, receives the timing and status of the measurement.
+	 * @param dropped If not NULL, receives the number of results overwritten since
+	 *        the previous call because the queue was full.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if a result was copied. Check `info->result` for the
+	 *          status of the measurement itself.
+	 *        - ERR_WRONG_STATE if no result is queued
+	 */
+	VNAEXT_API ErrCode reapScheduledMeasurement(TaskHandle t, ScheduledResult* info, unsigned int* dropped,
+	                                            ComplexData out0, ComplexData out1,
+	                                            ComplexData out2, ComplexData out3,
+	                                            ComplexData out4);
+
+	/**
+	 * @brief Transform frequency domain traces (e.g. the outputs of
+	 *        measure2PortCalibrated()) into time domain responses.
+	 *
+	 *        The transform is evaluated with a chirp-Z transform over the configured
+	 *        time span, so zero padding and zooming cost the same as a plain inverse
+	 *        FFT. Windows, phase terms and FFT plans are cached per frequency list
+	 *        and configuration, so repeated calls on the same sweep only pay for the
+	 *        transform itself. The traces are spread over a pool of one thread per
+	 *        core and written straight into the caller's buffers.
+	 *
+	 *        Responses are normalized so that a flat unit spectrum gives a peak of 1
+	 *        at t = 0. For TD_LOWPASS, the bins between DC and the first frequency
+	 *        are extrapolated linearly, and the real response is returned in `I`.
+	 *
+	 * @param freqs Array of `N` evenly spaced frequencies, in MHz.
+	 * @param N Number of frequency points (at least 2).
+	 * @param in Array of `traces` ComplexData, each holding `N` points.
+	 * @param traces Number of traces to transform.
+	 * @param config Transform configuration.
+	 * @param out Array of `traces` caller-allocated ComplexData, each holding at least
+	 *        `config->points` values. `Q` may be NULL for TD_LOWPASS.
+	 * @param times If not NULL, receives the `config->points` time points, in seconds.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_WRONG_PROGRAM_TYPE if the configuration is invalid, or a required pointer is NULL
+	 *        - ERR_MISSING_FREQS if there are fewer than 2 frequencies, they are not
+	 *          evenly spaced, or (TD_LOWPASS) they are not on a harmonic grid
+	 */
+	VNAEXT_API ErrCode timeDomainTransform(const double* freqs, const unsigned int N,
+	                                       const ComplexData* in, const unsigned int traces,
+	                                       const TimeDomainConfig* config,
+	                                       ComplexData* out, double* times);
+
+	/**
+	 * @brief Apply a time domain gate to frequency domain traces. Each trace is
+	 *        windowed, transformed to the time domain (band-pass, see
+	 *        timeDomainTransform()), multiplied by the gate, and transformed back
+	 *        to the original frequency points.
+	 *
+	 *        The result is normalized by the gated response of a flat spectrum.
+	 *        This removes both the frequency window and the roll-off that gating a
+	 *        finite band causes near its edges. Points where the frequency window
+	 *        is close to zero (the ends of a Hann or Blackman window) cannot be
+	 *        recovered and are returned as 0. Gate kernels and FFT plans are
+	 *        cached per frequency list and gate configuration, so repeated sweeps
+	 *        only pay for the two transforms. Traces are processed in parallel on
+	 *        the same pool as timeDomainTransform(). `out` may be the same as `in`.
+	 *
+	 * @param freqs Array of `N` evenly spaced frequencies, in MHz.
+	 * @param N Number of frequency points (at least 2).
+	 * @param in Array of `traces` ComplexData, each holding `N` points.
+	 * @param traces Number of traces to gate.
+	 * @param config Gate configuration.
+	 * @param out Array of `traces` caller-allocated ComplexData, each holding `N` points.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_WRONG_PROGRAM_TYPE if the configuration is invalid, or a pointer is NULL
+	 *        - ERR_MISSING_FREQS if there are fewer than 2 frequencies, or they are not
+	 *          evenly spaced
+	 */
+	VNAEXT_API ErrCode timeDomainGate(const double* freqs, const unsigned int N,
+	                                  const ComplexData* in, const unsigned int traces,
+	                                  const GateConfig* config, ComplexData* out);
+
+	/**
+	 * @brief Compute derived quantities of one trace (e.g. one output of
+	 *        measure2PortCalibrated()).
+	 *
+	 *        All requested quantities are computed in a single pass over `in`, so
+	 *        the trace is read from memory once however many are asked for.
+	 *        Group delay uses central differences of the unwrapped phase, and
+	 *        one-sided differences at the ends of the sweep.
+	 *
+	 * @param freqs Array of `N` frequencies, in MHz. Only needed for group delay;
+	 *        may be NULL otherwise.
+	 * @param N Number of points.
+	 * @param in The trace.
+	 * @param z0 Reference impedance for `resistance` and `reactance`, in Ohms.
+	 * @param out Output arrays; NULL members are skipped.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_WRONG_PROGRAM_TYPE if `out`, `in.I` or `in.Q` is NULL
+	 *        - ERR_MISSING_FREQS if group delay is requested and `freqs` is NULL
+	 */
+	VNAEXT_API ErrCode computeDerivedQuantities(const double* freqs, const unsigned int N, ComplexData in,
+	                                            const double z0, const DerivedQuantities* out);
+
+	/**
+	 * @brief Measure the Task and compute derived quantities of one output,
+	 *        without returning the I/Q data itself.
+	 *
+	 *        The measurement is taken into the Task's internal buffers (with
+	 *        calibration and segmented sweeps applied as in measureSegmented()),
+	 *        and the derived quantities are computed straight away while the
+	 *        trace is still in cache. The arrays in `out` must hold the number of
+	 *        points in the sweep.
+	 *
+	 * @param t Task handle.
+	 * @param kind MEAS_UNCALIBRATED or MEAS_2PORT_CALIBRATED.
+	 * @param output Index of the output to use, in the order of the measurement
+	 *        function's arguments (e.g. 0 for S11 of measure2PortCalibrated()).
+	 * @param z0 Reference impedance for `resistance` and `reactance`, in Ohms.
+	 * @param out Output arrays; NULL members are skipped. At least one must be set.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `kind` is invalid or no quantity is requested
+	 *        - ERR_BAD_PATH if `output` is out of range for `kind`
+	 *        - ERR_WRONG_STATE if another measurement is in progress on `t`, or a
+	 *          pipeline is attached (see attachPipeline())
+	 *        - Any of the measureSegmented() errors
+	 */
+	VNAEXT_API ErrCode measureDerived(TaskHandle t, const MeasurementKind kind, const unsigned int output,
+	                                  const double z0, const DerivedQuantities* out);
+
+	/**
+	 * @brief Convert two-port data between S, T and ABCD parameters, point by point.
+	 *
+	 * @param N Number of points.
+	 * @param in Array of 4 ComplexData in the \ref NetworkFormat order, each holding `N` points.
+	 * @param from Format of `in`.
+	 * @param to Format of `out`.
+	 * @param z0 Reference impedance for conversions to or from ABCD, in Ohms.
+	 * @param out Array of 4 caller-allocated ComplexData, each holding `N` points.
+	 *        May be the same arrays as `in`.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_WRONG_PROGRAM_TYPE if a format is invalid or a pointer is NULL
+	 */
+	VNAEXT_API ErrCode convertTwoPort(const unsigned int N, const ComplexData* in,
+	                                  const NetworkFormat from, const NetworkFormat to,
+	                                  const double z0, ComplexData* out);
+
+	/**
+	 * @brief Remove test fixtures from every calibrated measurement of Task `t`.
+	 *
+	 *        The measured network is taken to be port 1 fixture, port 1 extension,
+	 *        DUT, port 2 extension, port 2 fixture, in cascade. The inverse of each
+	 *        side is computed once here, per frequency, so de-embedding a sweep is a
+	 *        few 2x2 complex products per point. Once set, every calibrated
+	 *        measurement of the Task (measureSegmented(), submitMeasurement(),
+	 *        the scheduler, ...) returns de-embedded S-parameters; the sweep must
+	 *        then be `freqs`, as returned by getSegmentedFrequencies(), or the
+	 *        measurement fails with ERR_MISSING_FREQS.
+	 *        Uncalibrated measurements are not affected.
+	 *
+	 *        The fixture may be replaced at any time; a measurement already in
+	 *        flight finishes with the fixture it started with.
+	 *
+	 * @param t Task handle.
+	 * @param freqs Array of `N` frequencies the fixture data was taken at, in MHz.
+	 * @param N Number of frequencies.
+	 * @param port1_fixture S-parameters of the port 1 fixture (4 ComplexData, see
+	 *        \ref NetworkFormat), port 1 toward the VNA. NULL if there is none.
+	 * @param port2_fixture S-parameters of the port 2 fixture, port 1 toward the
+	 *        DUT. NULL if there is none.
+	 * @param port1_delay Port 1 extension, as an electrical delay in seconds. 0 for none.
+	 * @param port2_delay Port 2 extension, as an electrical delay in seconds. 0 for none.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_MISSING_FREQS if `freqs` is NULL or `N` is 0
+	 *        - ERR_WRONG_PROGRAM_TYPE if a fixture is missing one of its arrays
+	 *        - ERR_BAD_CAL if a fixture does not transmit (S21 = 0) at some frequency
+	 */
+	VNAEXT_API ErrCode setDeembedding(TaskHandle t, const double* freqs, const unsigned int N,
+	                                  const ComplexData* port1_fixture, const ComplexData* port2_fixture,
+	                                  const double port1_delay, const double port2_delay);
+
+	/**
+	 * @brief Stop de-embedding the measurements of Task `t`.
+	 *
+	 * @param t Task handle.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 */
+	VNAEXT_API ErrCode clearDeembedding(TaskHandle t);
+
+	/**
+	 * @brief Apply the de-embedding set on Task `t` to stored sweeps, e.g. ones
+	 *        measured before setDeembedding() was called. Sweeps are processed
+	 *        in parallel on the same pool as timeDomainTransform().
+	 *
+	 * @param t Task handle.
+	 * @param in Array of `sweeps` * 4 ComplexData: the S-parameters of each sweep in
+	 *        turn, each holding as many points as the fixture frequency list.
+	 * @param sweeps Number of sweeps.
+	 * @param out Array laid out like `in`. May be the same arrays as `in`.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if a pointer is NULL
+	 *        - ERR_WRONG_STATE if no de-embedding is set on `t`
+	 */
+	VNAEXT_API ErrCode deembedSweeps(TaskHandle t, const ComplexData* in, const unsigned int sweeps,
+	                                 ComplexData* out);
+
+	/**
+	 * @brief Average the sweeps of every extension measurement on Task `t`
+	 *        (measureSegmented(), submitMeasurement(), the scheduler, ...).
+	 *
+	 *        With AVERAGE_BLOCK, each measurement takes `N` sweeps and returns
+	 *        their mean, so it takes `N` times as long. With AVERAGE_EXPONENTIAL,
+	 *        each measurement takes one sweep x and returns
+	 *        avg += (x - avg) / min(k, N), where k counts the sweeps since the
+	 *        average was restarted; the first `N` measurements are therefore
+	 *        plain running means. The exponential average restarts by itself
+	 *        when the measurement kind, the number of points or the set of
+	 *        requested arrays changes. I and Q are averaged independently, so
+	 *        an output passed with only one of its arrays is averaged too.
+	 *
+	 *        Sweeps are summed into the output buffers as they arrive, so the
+	 *        caller only ever sees the averaged result. Averaging is applied to
+	 *        the calibrated data, before any de-embedding (see setDeembedding()).
+	 *        Continuous-wave streaming is not averaged.
+	 *
+	 * @param t Task handle.
+	 * @param mode One of the \ref AverageMode values.
+	 * @param N Number of sweeps to average. Ignored for AVERAGE_OFF.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `mode` is invalid, or `N` is 0
+	 */
+	VNAEXT_API ErrCode setAveraging(TaskHandle t, const AverageMode mode, const unsigned int N);
+
+	/**
+	 * @brief Discard the exponential average of Task `t`, e.g. after the DUT
+	 *        changed. The next measurement starts a new average.
+	 *
+	 * @param t Task handle.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 */
+	VNAEXT_API ErrCode restartAveraging(TaskHandle t);
+
+	/**
+	 * @brief Creates an accumulator for running per-point statistics: mean,
+	 *        variance and magnitude extremes of every output, over any number of
+	 *        sweeps, without storing the sweeps. Statistics are updated with
+	 *        Welford's method, so they stay accurate over long runs.
+	 *
+	 * @return new statistics handle
+	 */
+	VNAEXT_API StatisticsHandle createStatistics();
+
+	/**
+	 * @brief Deletes an accumulator. A Task it is still attached to keeps feeding
+	 *        its own reference until attachStatistics(t, NULL) is called.
+	 *
+	 * @param s Accumulator to delete.
+	 */
+	VNAEXT_API void deleteStatistics(StatisticsHandle s);
+
+	/**
+	 * @brief Discard every sweep added so far. The next sweep also sets the
+	 *        number of points again.
+	 *
+	 * @param s Statistics handle.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `s` is NULL
+	 */
+	VNAEXT_API ErrCode resetStatistics(StatisticsHandle s);
+
+	/**
+	 * @brief Add one sweep to an accumulator by hand. The outputs are passed in
+	 *        the order of the measureUncalibrated() (or measure2PortCalibrated())
+	 *        arguments; outputs with a NULL `I` or `Q` are skipped, so each output
+	 *        counts its own sweeps.
+	 *
+	 * @param s Statistics handle.
+	 * @param N Number of points in the sweep. Every sweep added to an accumulator
+	 *        must have the same number of points.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `s` is NULL
+	 *        - ERR_MISSING_FREQS if `N` is 0 or differs from the earlier sweeps
+	 */
+	VNAEXT_API ErrCode addToStatistics(StatisticsHandle s, const unsigned int N,
+	                                   ComplexData out0, ComplexData out1,
+	                                   ComplexData out2, ComplexData out3,
+	                                   ComplexData out4);
+
+	/**
+	 * @brief Feed every extension measurement of Task `t` (measureSegmented(),
+	 *        submitMeasurement(), the scheduler, ...) into an accumulator, as it
+	 *        is returned: after averaging and de-embedding. Every output the
+	 *        measurement fills is added; measureSegmented() only fills those the
+	 *        caller passed buffers for. A measurement whose number of points
+	 *        differs from the accumulator's is not added, but still succeeds;
+	 *        getStatistics() reports the mismatch.
+	 *
+	 *        The same accumulator may be attached to several Tasks.
+	 *
+	 * @param t Task handle.
+	 * @param s Statistics handle, or NULL to detach the current one.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 */
+	VNAEXT_API ErrCode attachStatistics(TaskHandle t, StatisticsHandle s);
+
+	/**
+	 * @brief Snapshot the statistics of one output. May be called at any time,
+	 *        including while measurements are feeding the accumulator.
+	 *
+	 * @param s Statistics handle.
+	 * @param output Index of the output, in the order of the measurement
+	 *        function's arguments.
+	 * @param sweeps If not NULL, receives the number of sweeps added for `output`.
+	 *        Nothing else is written if it is 0.
+	 * @param mean Caller-allocated arrays for the complex mean. Either may be NULL.
+	 * @param variance If not NULL, receives the unbiased variance E|x - mean|^2
+	 *        (0 after a single sweep).
+	 * @param min_magnitude If not NULL, receives the smallest |x| seen.
+	 * @param max_magnitude If not NULL, receives the largest |x| seen.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `s` is NULL
+	 *        - ERR_BAD_PATH if `output` is more than 4
+	 *        - ERR_MISSING_FREQS if a measurement of a Task the accumulator is
+	 *          attached to was left out since the last resetStatistics(), because
+	 *          its number of points differed. The snapshot is still returned.
+	 */
+	VNAEXT_API ErrCode getStatistics(StatisticsHandle s, const unsigned int output, unsigned int* sweeps,
+	                                 ComplexData mean, double* variance,
+	                                 double* min_magnitude, double* max_magnitude);
+
+	/**
+	 * @brief Subtract a stored background (e.g. an empty-scene sweep) from every
+	 *        uncalibrated extension measurement of Task `t` (measureSegmented(),
+	 *        submitMeasurement(), the scheduler, ...). The subtraction runs after
+	 *        averaging, in place in the returned buffers.
+	 *
+	 *        Outputs passed as NULL here are not subtracted. A measurement whose
+	 *        number of points differs from `N` fails with ERR_MISSING_FREQS,
+	 *        unless the background adapts (see setBaselineAdaptation()).
+	 *
+	 * @param t Task handle.
+	 * @param N Number of points in the background sweep.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_MISSING_FREQS if `N` is 0
+	 */
+	VNAEXT_API ErrCode setBaseline(TaskHandle t, const unsigned int N,
+	                               ComplexData out0, ComplexData out1,
+	                               ComplexData out2, ComplexData out3,
+	                               ComplexData out4);
+
+	/**
+	 * @brief Let the background of Task `t` follow slow changes in the scene.
+	 *        After each measurement x is returned as x - b, the background is
+	 *        updated as b += alpha (x - b), giving a clutter estimate with a time
+	 *        constant of about 1 / alpha sweeps.
+	 *
+	 *        If no background has been set with setBaseline(), or the number of
+	 *        points changes, the next sweep becomes the starting background (and
+	 *        is returned as all zeros).
+	 *
+	 * @param t Task handle.
+	 * @param alpha Adaptation rate in [0, 1]. 0 freezes the current background.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `alpha` is outside [0, 1]
+	 */
+	VNAEXT_API ErrCode setBaselineAdaptation(TaskHandle t, const double alpha);
+
+	/**
+	 * @brief Stop subtracting a background from the measurements of Task `t`,
+	 *        and forget the stored one.
+	 *
+	 * @param t Task handle.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 */
+	VNAEXT_API ErrCode clearBaseline(TaskHandle t);
+
+	/**
+	 * @brief Creates an empty post-processing pipeline. Stages are appended with
+	 *        the add*Stage() functions and run in the order they were added; the
+	 *        pipeline is then attached to a Task with attachPipeline().
+	 *
+	 *        Calibration is not a stage: it is selected by measuring with
+	 *        MEAS_2PORT_CALIBRATED, and the pipeline then runs on the S-parameters.
+	 *
+	 * @return new pipeline handle
+	 */
+	VNAEXT_API PipelineHandle createPipeline();
+
+	/**
+	 * @brief Deletes a pipeline definition. Tasks it was attached to keep their own copy.
+	 *
+	 * @param p Pipeline to delete.
+	 */
+	VNAEXT_API void deletePipeline(PipelineHandle p);
+
+	/**
+	 * @brief Append a stage that divides every path by the Ref path, point by point,
+	 *        as setRatioMode() does. The Ref output itself passes through
+	 *        unchanged, and points where Ref is (numerically) zero give 0. The
+	 *        stage has no effect on calibrated measurements.
+	 *
+	 * @param p Pipeline handle.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `p` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if an inverse FFT or decimation stage comes
+	 *          before it, since the points would no longer line up with Ref
+	 */
+	VNAEXT_API ErrCode addRatioStage(PipelineHandle p);
+
+	/**
+	 * @brief Append an exponential moving average over about `N` sweeps, kept
+	 *        per output. Unlike setAveraging(), this averages the data as it
+	 *        reaches the stage, e.g. after a ratio.
+	 *
+	 * @param p Pipeline handle.
+	 * @param N Number of sweeps; the weight of a new sweep is 1 / min(k, N).
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `p` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `N` is 0
+	 */
+	VNAEXT_API ErrCode addAverageStage(PipelineHandle p, const unsigned int N);
+
+	/**
+	 * @brief Append a window over the points reaching the stage.
+	 *
+	 * @param p Pipeline handle.
+	 * @param window One of the \ref WindowType values.
+	 * @param parameter Kaiser window beta; ignored by the other windows.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `p` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `window` is invalid
+	 */
+	VNAEXT_API ErrCode addWindowStage(PipelineHandle p, const WindowType window, const double parameter);
+
+	/**
+	 * @brief Append an inverse FFT, e.g. to turn a sweep into a range profile.
+	 *        The input is zero-padded to the FFT size, and the result is scaled
+	 *        so that a flat spectrum gives a unit impulse. Unlike
+	 *        timeDomainTransform(), the frequencies are not checked for even
+	 *        spacing.
+	 *
+	 * @param p Pipeline handle.
+	 * @param points FFT size, a power of two, or 0 for the smallest power of two
+	 *        that holds the input. A size smaller than the input is rounded up the same way.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `p` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `points` is not a power of two
+	 */
+	VNAEXT_API ErrCode addInverseFftStage(PipelineHandle p, const unsigned int points);
+
+	/**
+	 * @brief Append a stage that replaces every point with its magnitude, returned
+	 *        in `I`, with `Q` set to 0.
+	 *
+	 * @param p Pipeline handle.
+	 * @param db If true, return 20 log10 |x| instead of |x|.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `p` is NULL
+	 */
+	VNAEXT_API ErrCode addMagnitudeStage(PipelineHandle p, const bool db);
+
+	/**
+	 * @brief Append a stage that averages each group of `factor` consecutive
+	 *        points into one. Trailing points that do not fill a group are dropped.
+	 *
+	 * @param p Pipeline handle.
+	 * @param factor Decimation factor.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `p` is NULL
+	 *        - ERR_WRONG_PROGRAM_TYPE if `factor` is 0
+	 */
+	VNAEXT_API ErrCode addDecimationStage(PipelineHandle p, const unsigned int factor);
+
+	/**
+	 * @brief Number of points per output a pipeline produces from an `N` point sweep.
+	 *
+	 * @param p Pipeline handle. NULL gives `N`.
+	 * @param N Number of points in the sweep.
+	 * @return number of points per output
+	 */
+	VNAEXT_API unsigned int getPipelineOutputPoints(PipelineHandle p, const unsigned int N);
+
+	/**
+	 * @brief Run a copy of pipeline `p` on every extension measurement of Task `t`
+	 *        (measureSegmented(), submitMeasurement(), the scheduler). The
+	 *        pipeline runs after averaging, background subtraction and
+	 *        de-embedding, and its result is what the measurement returns: every
+	 *        output buffer must then hold getPipelineOutputPoints() points. Attach
+	 *        the pipeline again after adding stages to it.
+	 *
+	 *        The sweep is measured into buffers owned by the pipeline, which are
+	 *        only reallocated when the number of points changes. Consecutive
+	 *        point-by-point stages are run together over blocks of points that
+	 *        stay in cache, and for long sweeps the outputs are processed in
+	 *        parallel on the same pool as timeDomainTransform().
+	 *
+	 * @param t Task handle.
+	 * @param p Pipeline handle, or NULL to detach the current pipeline.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_STATE if a measurement is in flight on `t`
+	 */
+	VNAEXT_API ErrCode attachPipeline(TaskHandle t, PipelineHandle p);
+
+	/**
+	 * @brief Return the measured paths normalized by the Ref path, to cancel
+	 *        source drift. While enabled, every uncalibrated extension
+	 *        measurement of Task `t` (measureSegmented(), submitMeasurement(), the
+	 *        scheduler, ...) returns T1R1 / Ref, T1R2 / Ref, T2R1 / Ref and
+	 *        T2R2 / Ref in outputs 0 to 3. Ref is still measured, but is only
+	 *        copied out if the caller passes a buffer for it. Points where Ref
+	 *        has (numerically) no power are returned as 0.
+	 *
+	 *        The reciprocal of Ref is computed once per point and multiplied into
+	 *        each path. The ratio is taken after averaging and before background
+	 *        subtraction. Calibrated measurements are not affected.
+	 *
+	 * @param t Task handle.
+	 * @param enabled True to return ratios, false for the raw paths (default).
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 */
+	VNAEXT_API ErrCode setRatioMode(TaskHandle t, const bool enabled);
+
+	/**
+	 * @brief Start slow-time (sweep to sweep) Doppler processing on Task `t`.
+	 *        Output `config->output` of every extension measurement
+	 *        (measureSegmented(), submitMeasurement(), the scheduler, ...) is
+	 *        collected, as it is returned: with a pipeline ending in an inverse
+	 *        FFT stage (see addInverseFftStage()), each point is a range bin.
+	 *
+	 *        Every `config->sweeps` consecutive sweeps form a block, stored with
+	 *        the sweeps of each range bin next to each other. A full block is
+	 *        windowed across the sweeps and Fourier transformed per range bin on
+	 *        the same pool as timeDomainTransform(), without holding up the next
+	 *        measurement; blocks of several Tasks are processed in parallel. If a
+	 *        block fills up while the previous one is still being processed, it is
+	 *        dropped (see DopplerMapInfo.dropped). A change in the number of points
+	 *        per sweep starts a new block.
+	 *
+	 *        Sweeps are timestamped on the host as their measurement completes.
+	 *        A measurement that does not return `config->output` (a NULL buffer
+	 *        passed to measureSegmented(), or output 4 of a calibrated measurement)
+	 *        is not collected.
+	 *
+	 *        Calling startDoppler() again restarts processing with the new
+	 *        configuration and discards any collected sweeps and maps.
+	 *
+	 * @param t Task handle.
+	 * @param config Doppler configuration.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_BAD_PATH if `config->output` is more than 4
+	 *        - ERR_WRONG_PROGRAM_TYPE if `config` is NULL, or `sweeps`, `doppler_points`
+	 *          or `window` is invalid
+	 *        - ERR_WRONG_STATE if a measurement is in flight on `t`
+	 */
+	VNAEXT_API ErrCode startDoppler(TaskHandle t, const DopplerConfig* config);
+
+	/**
+	 * @brief Stop the Doppler processing started by startDoppler(). Collected
+	 *        sweeps and maps are discarded; a block still being processed
+	 *        completes in the background.
+	 *
+	 * @param t Task handle.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_STATE if Doppler processing is not started
+	 */
+	VNAEXT_API ErrCode stopDoppler(TaskHandle t);
+
+	/**
+	 * @brief Copy the latest complete Doppler map of Task `t`. May be called at
+	 *        any time, including while measurements are running; compare
+	 *        DopplerMapInfo.sequence between calls to detect a new map.
+	 *
+	 *        The map holds `range_bins` rows of `doppler_bins` values: value
+	 *        `r * doppler_bins + k` is Doppler bin `k` of range bin `r`. Zero
+	 *        Doppler is at bin `doppler_bins / 2`.
+	 *
+	 * @param t Task handle.
+	 * @param map Caller-allocated arrays of `range_bins * doppler_bins` values.
+	 *        Either may be NULL, e.g. to only read `info`.
+	 * @param info If not NULL, receives the description of the map.
+	 * @return Call status - Possible return values:
+	 *        - ERR_OK if all went according to plan
+	 *        - ERR_BAD_HANDLE if `t` is NULL
+	 *        - ERR_WRONG_STATE if Doppler processing is not started, or no map
+	 *          is complete yet
+	 */
+	VNAEXT_API ErrCode getDopplerMap(TaskHandle t, ComplexData map, DopplerMapInfo* info);
+
+// <<<<<< CPP WRAP START
+	#ifdef __cplusplus
+		}  // end extern
+	#endif
+// CPP WRAP END >>>>>>>>
+
+
+/** @}*/
+
+#endif
+
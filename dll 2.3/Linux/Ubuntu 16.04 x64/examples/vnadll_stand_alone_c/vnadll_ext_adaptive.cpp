@@ -0,0 +1,277 @@
+// vnadll_ext_adaptive.cpp : Adaptive coarse-to-fine sweeps.
+//
+
+#include <algorithm>
+#include <math.h>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+AdaptiveMetric ADAPT_CURVATURE   = 1;
+AdaptiveMetric ADAPT_PHASE_SLOPE = 2;
+AdaptiveMetric ADAPT_NOTCH_DEPTH = 3;
+
+// Points measured so far, sorted by frequency.
+struct AdaptiveData
+{
+	std::vector<double> freqs;
+	std::vector<double> i[NUM_OUTPUTS];
+	std::vector<double> q[NUM_OUTPUTS];
+};
+
+static double magnitude(const AdaptiveData& data, int path, size_t n)
+{
+	return hypot(data.i[path][n], data.q[path][n]);
+}
+
+// Relative deviation of point `n` from the straight line through its neighbours.
+static double curvatureAt(const AdaptiveData& data, int path, size_t n)
+{
+	if (n == 0 || n + 1 >= data.freqs.size())
+		return 0;
+
+	const std::vector<double>& f = data.freqs;
+	double w = (f[n] - f[n - 1]) / (f[n + 1] - f[n - 1]);
+	double di = data.i[path][n - 1] + (data.i[path][n + 1] - data.i[path][n - 1]) * w - data.i[path][n];
+	double dq = data.q[path][n - 1] + (data.q[path][n + 1] - data.q[path][n - 1]) * w - data.q[path][n];
+	return hypot(di, dq) / fmax(magnitude(data, path, n), 1e-12);
+}
+
+// Score of the interval between points `n` and `n + 1`; intervals scoring above
+// the threshold get refined.
+static double intervalScore(const AdaptiveData& data, AdaptiveMetric metric, int path, size_t n)
+{
+	if (metric == ADAPT_PHASE_SLOPE)
+	{
+		// Phase change across the interval, wrapped to [0, pi].
+		double re = data.i[path][n] * data.i[path][n + 1] + data.q[path][n] * data.q[path][n + 1];
+		double im = data.i[path][n] * data.q[path][n + 1] - data.q[path][n] * data.i[path][n + 1];
+		return fabs(atan2(im, re));
+	}
+	if (metric == ADAPT_NOTCH_DEPTH)
+	{
+		// Change in log-magnitude across the interval, in dB.
+		double a = fmax(magnitude(data, path, n), 1e-12);
+		double b = fmax(magnitude(data, path, n + 1), 1e-12);
+		return fabs(20 * log10(b / a));
+	}
+	return fmax(curvatureAt(data, path, n), curvatureAt(data, path, n + 1));
+}
+
+// Set `freqs` as the sweep of `et`, measure it, and merge the result into `data`.
+// Corrections are left to the complete sweep, see measureAdaptive().
+static ErrCode measureAndMerge(ExtTask* et, MeasurementKind kind, const std::vector<double>& freqs,
+                               AdaptiveData& data)
+{
+	TaskHandle t = et->handle;
+	ErrCode code = stop(t);
+	if (code == ERR_OK)
+		code = loadPlan(et, freqs.data(), (unsigned int)freqs.size());
+	if (code == ERR_OK)
+		code = start(t);
+	if (code != ERR_OK)
+		return code;
+
+	et->points = sweepPoints(et);
+	ComplexData out[NUM_OUTPUTS];
+	bindBuffers(et, out);
+	if (kind == MEAS_2PORT_CALIBRATED)
+		out[4].I = out[4].Q = NULL;
+	code = measureRaw(et, kind, out);
+	if (code != ERR_OK)
+		return code;
+
+	// Merge the new points (sorted, in plan order) with the existing ones.
+	const std::vector<double>& measured = et->plan.freqs;
+	size_t old_n = data.freqs.size();
+	size_t new_n = measured.size();
+	std::vector<size_t> from(old_n + new_n);
+	std::vector<double> merged(old_n + new_n);
+	size_t a = 0;
+	size_t b = 0;
+	for (size_t x = 0; x < merged.size(); x += 1)
+	{
+		if (b >= new_n || (a < old_n && data.freqs[a] < measured[b]))
+		{
+			merged[x] = data.freqs[a];
+			from[x] = a++;
+		}
+		else
+		{
+			merged[x] = measured[b];
+			from[x] = old_n + b++;
+		}
+	}
+
+	for (int p = 0; p < NUM_OUTPUTS; p += 1)
+	{
+		std::vector<double> mi(merged.size());
+		std::vector<double> mq(merged.size());
+		for (size_t x = 0; x < merged.size(); x += 1)
+		{
+			size_t n = from[x];
+			mi[x] = n < old_n ? data.i[p][n] : et->buf_i[p][n - old_n];
+			mq[x] = n < old_n ? data.q[p][n] : et->buf_q[p][n - old_n];
+		}
+		data.i[p].swap(mi);
+		data.q[p].swap(mq);
+	}
+	data.freqs.swap(merged);
+	return ERR_OK;
+}
+
+// Choose the follow-up points: up to `budget` legal, new frequencies inside the
+// highest-scoring intervals.
+static ErrCode refinementPoints(TaskHandle t, const AdaptiveSweep* config, const AdaptiveData& data,
+                                size_t budget, std::vector<double>& freqs)
+{
+	std::vector<std::pair<double, size_t> > intervals;
+	for (size_t n = 0; n + 1 < data.freqs.size(); n += 1)
+	{
+		double score = intervalScore(data, config->metric, (int)config->output, n);
+		if (score > config->threshold)
+			intervals.push_back(std::make_pair(score, n));
+	}
+	std::sort(intervals.begin(), intervals.end(),
+	          [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) { return a.first > b.first; });
+
+	freqs.clear();
+	unsigned int split = config->refine_points;
+	for (size_t x = 0; x < intervals.size() && freqs.size() + split <= budget; x += 1)
+	{
+		size_t n = intervals[x].second;
+		double lo = data.freqs[n];
+		double hi = data.freqs[n + 1];
+		for (unsigned int y = 1; y <= split; y += 1)
+			freqs.push_back(lo + (hi - lo) * y / (split + 1));
+	}
+	if (freqs.empty())
+		return ERR_OK;
+
+	ErrCode code = utilNearestLegalFreqs(t, freqs.data(), (unsigned int)freqs.size());
+	if (code != ERR_OK)
+		return code;
+
+	// Drop points that snapped onto each other or onto an already measured point.
+	std::sort(freqs.begin(), freqs.end());
+	freqs.erase(std::unique(freqs.begin(), freqs.end(),
+	                        [](double a, double b) { return b - a < DUPLICATE_FREQ_TOLERANCE; }),
+	            freqs.end());
+	freqs.erase(std::remove_if(freqs.begin(), freqs.end(), [&data](double f)
+	{
+		std::vector<double>::const_iterator it = std::lower_bound(data.freqs.begin(), data.freqs.end(), f - DUPLICATE_FREQ_TOLERANCE);
+		return it != data.freqs.end() && *it - f < DUPLICATE_FREQ_TOLERANCE;
+	}), freqs.end());
+	return ERR_OK;
+}
+
+static ErrCode runAdaptive(ExtTask* et, MeasurementKind kind, const AdaptiveSweep* config,
+                           AdaptiveData& data)
+{
+	TaskHandle t = et->handle;
+
+	std::vector<double> freqs(config->coarse_points);
+	for (unsigned int x = 0; x < config->coarse_points; x += 1)
+		freqs[x] = config->start_frequency
+		           + (config->stop_frequency - config->start_frequency) * x / (config->coarse_points - 1);
+	ErrCode code = utilNearestLegalFreqs(t, freqs.data(), (unsigned int)freqs.size());
+	if (code != ERR_OK)
+		return code;
+	std::sort(freqs.begin(), freqs.end());
+	freqs.erase(std::unique(freqs.begin(), freqs.end(),
+	                        [](double a, double b) { return b - a < DUPLICATE_FREQ_TOLERANCE; }),
+	            freqs.end());
+
+	code = measureAndMerge(et, kind, freqs, data);
+	for (unsigned int pass = 0; code == ERR_OK && pass < config->max_passes; pass += 1)
+	{
+		code = refinementPoints(t, config, data, config->max_points - data.freqs.size(), freqs);
+		if (code != ERR_OK || freqs.empty())
+			break;
+		code = measureAndMerge(et, kind, freqs, data);
+	}
+	if (code != ERR_OK)
+		return code;
+
+	// Leave the complete adaptive list set, so measureSegmented() repeats it.
+	code = stop(t);
+	if (code == ERR_OK)
+		code = loadPlan(et, data.freqs.data(), (unsigned int)data.freqs.size());
+	if (code == ERR_OK)
+		code = start(t);
+	if (code != ERR_OK)
+		return code;
+
+	// Background subtraction, de-embedding, statistics and Doppler processing
+	// see the complete sweep once, as for measureSegmented().
+	ComplexData out[NUM_OUTPUTS];
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		out[x].I = data.i[x].data();
+		out[x].Q = data.q[x].data();
+	}
+	if (kind == MEAS_2PORT_CALIBRATED)
+		out[4].I = out[4].Q = NULL;
+	code = applyCorrections(et, kind, out);
+	if (code == ERR_OK)
+		feedAccumulators(et, kind, out);
+	return code;
+}
+
+ErrCode measureAdaptive(TaskHandle t, const MeasurementKind kind, const AdaptiveSweep* config,
+                        double* freqs, unsigned int* N,
+                        ComplexData out0, ComplexData out1,
+                        ComplexData out2, ComplexData out3,
+                        ComplexData out4)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (kind != MEAS_UNCALIBRATED && kind != MEAS_2PORT_CALIBRATED)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (!config || !N || config->refine_points == 0)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (config->metric != ADAPT_CURVATURE && config->metric != ADAPT_PHASE_SLOPE
+	    && config->metric != ADAPT_NOTCH_DEPTH)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (config->output >= (unsigned int)(kind == MEAS_2PORT_CALIBRATED ? 4 : NUM_OUTPUTS))
+		return ERR_BAD_PATH;
+	if (config->coarse_points < 2 || config->coarse_points > config->max_points)
+		return ERR_MISSING_FREQS;
+	if (getState(t) != TASK_STARTED)
+		return ERR_WRONG_STATE;
+
+	ExtTask* et = getExtTask(t);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		if (et->in_flight || et->submitted || et->pipeline)
+			return ERR_WRONG_STATE;
+		et->in_flight = true;
+	}
+
+	AdaptiveData data;
+	ErrCode code = runAdaptive(et, kind, config, data);
+	if (code == ERR_OK)
+	{
+		ComplexData out[NUM_OUTPUTS] = { out0, out1, out2, out3, out4 };
+		if (kind == MEAS_2PORT_CALIBRATED)
+			out[4].I = out[4].Q = NULL;
+
+		size_t n = data.freqs.size();
+		*N = (unsigned int)n;
+		if (freqs)
+			std::copy(data.freqs.begin(), data.freqs.end(), freqs);
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			if (out[x].I)
+				std::copy(data.i[x].begin(), data.i[x].end(), out[x].I);
+			if (out[x].Q)
+				std::copy(data.q[x].begin(), data.q[x].end(), out[x].Q);
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->in_flight = false;
+	et->cv.notify_all();
+	return code;
+}
@@ -0,0 +1,150 @@
+// vnadll_ext_async.cpp : Non-blocking measurement API with descriptor-based completion.
+//
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+// Runs on the io pool. After a cancelMeasurement() the DLL call is left to drain
+// here in the background; a submission made in the meantime is chained onto the
+// same worker so it starts as soon as the Task is free again.
+static void runSubmitted(ExtTask* et)
+{
+	std::unique_lock<std::mutex> guard(et->lock);
+	while (true)
+	{
+		ComplexData out[NUM_OUTPUTS];
+		bindBuffers(et, out);
+		MeasurementKind kind = et->kind;
+		if (kind == MEAS_2PORT_CALIBRATED)
+			out[4].I = out[4].Q = NULL;
+
+		guard.unlock();
+		ErrCode code = measureInto(et, kind, out);
+		guard.lock();
+
+		if (!et->abandoned)
+		{
+			et->result = code;
+			et->done = true;
+			et->signalCompletion();
+		}
+		et->abandoned = false;
+		et->abort = false;
+
+		if (!et->queued)
+			break;
+		et->queued = false;
+	}
+
+	et->in_flight = false;
+	et->cv.notify_all();
+}
+
+ErrCode submitMeasurement(TaskHandle t, const MeasurementKind kind)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (kind != MEAS_UNCALIBRATED && kind != MEAS_2PORT_CALIBRATED)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (getState(t) != TASK_STARTED)
+		return ERR_WRONG_STATE;
+
+	ExtTask* et = getExtTask(t);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		if (et->submitted || et->cw.running || et->schedule.running)
+			return ERR_WRONG_STATE;
+		if (kind == MEAS_2PORT_CALIBRATED && !et->lazy_factory_cal && !isCalibrationComplete(t))
+			return ERR_BAD_CAL;
+
+		et->submitted = true;
+		et->done = false;
+		et->kind = kind;
+		et->points = resultPoints(et);
+
+		// A cancelled call is still draining; run this one right after it.
+		if (et->in_flight)
+		{
+			et->queued = true;
+			return ERR_OK;
+		}
+		et->in_flight = true;
+	}
+
+	ioPool().submit([et] { runSubmitted(et); });
+	return ERR_OK;
+}
+
+ErrCode cancelMeasurement(TaskHandle t)
+{
+	ExtTask* et = findExtTask(t);
+	if (!et)
+		return ERR_WRONG_STATE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (!et->submitted || et->done)
+		return ERR_WRONG_STATE;
+
+	if (et->queued)
+		et->queued = false;
+	else
+	{
+		// Between two segments of a sweep the Task is stopped and the DLL
+		// rejects the interrupt with ERR_WRONG_STATE; the abort flag then stops
+		// the worker before it measures again.
+		et->abort = true;
+		ErrCode code = interruptMeasurement(t);
+		if (code != ERR_OK && code != ERR_WRONG_STATE)
+			return code;
+		et->abandoned = true;
+	}
+
+	et->result = ERR_INTERRUPTED;
+	et->done = true;
+	et->signalCompletion();
+	return ERR_OK;
+}
+
+int getCompletionFd(TaskHandle t)
+{
+	ExtTask* et = getExtTask(t);
+	return et ? et->completion_fd : -1;
+}
+
+bool isMeasurementReady(TaskHandle t)
+{
+	ExtTask* et = findExtTask(t);
+	if (!et)
+		return false;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	return et->submitted && et->done;
+}
+
+ErrCode reapMeasurement(TaskHandle t,
+                        ComplexData out0, ComplexData out1,
+                        ComplexData out2, ComplexData out3,
+                        ComplexData out4)
+{
+	ExtTask* et = findExtTask(t);
+	if (!et)
+		return ERR_WRONG_STATE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (!et->submitted || !et->done)
+		return ERR_WRONG_STATE;
+
+	if (et->result == ERR_OK)
+	{
+		ComplexData out[NUM_OUTPUTS] = { out0, out1, out2, out3, out4 };
+		if (et->kind == MEAS_2PORT_CALIBRATED)
+			out[4].I = out[4].Q = NULL;
+		copyBuffers(et, out, et->points);
+	}
+
+	et->drainCompletion();
+	et->submitted = false;
+	et->done = false;
+	return et->result;
+}
@@ -0,0 +1,187 @@
+// vnadll_ext_average.cpp : Block and exponential sweep averaging.
+//
+
+#include <algorithm>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+AverageMode AVERAGE_OFF         = 0;
+AverageMode AVERAGE_BLOCK       = 1;
+AverageMode AVERAGE_EXPONENTIAL = 2;
+
+// Bit 2x set if output `x` has an I array, bit 2x + 1 if it has a Q array.
+static unsigned int arrayMask(const ComplexData out[NUM_OUTPUTS])
+{
+	unsigned int mask = 0;
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		if (out[x].I)
+			mask |= 1u << (2 * x);
+		if (out[x].Q)
+			mask |= 1u << (2 * x + 1);
+	}
+	return mask;
+}
+
+static void accumulate(double* acc, const double* in, size_t n)
+{
+	for (size_t x = 0; x < n; x += 1)
+		acc[x] += in[x];
+}
+
+static void scale(double* data, double factor, size_t n)
+{
+	for (size_t x = 0; x < n; x += 1)
+		data[x] *= factor;
+}
+
+// state += (in - state) * weight; in = state
+static void blend(double* state, double* in, double weight, size_t n)
+{
+	for (size_t x = 0; x < n; x += 1)
+	{
+		state[x] += (in[x] - state[x]) * weight;
+		in[x] = state[x];
+	}
+}
+
+// Sum `count` sweeps into `out`, then scale. The first sweep lands in `out`
+// directly; the rest go through one set of scratch buffers.
+static ErrCode blockAverage(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS],
+                            unsigned int count)
+{
+	ErrCode code = measureSweep(et, kind, out);
+	if (code != ERR_OK || count < 2)
+		return code;
+
+	Averaging& avg = et->averaging;
+	size_t n = sweepPoints(et);
+	ComplexData scratch[NUM_OUTPUTS];
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		avg.i[x].resize(out[x].I ? n : 0);
+		avg.q[x].resize(out[x].Q ? n : 0);
+		scratch[x].I = out[x].I ? avg.i[x].data() : NULL;
+		scratch[x].Q = out[x].Q ? avg.q[x].data() : NULL;
+	}
+
+	for (unsigned int sweep = 1; sweep < count; sweep += 1)
+	{
+		code = measureSweep(et, kind, scratch);
+		if (code != ERR_OK)
+			return code;
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			if (out[x].I)
+				accumulate(out[x].I, scratch[x].I, n);
+			if (out[x].Q)
+				accumulate(out[x].Q, scratch[x].Q, n);
+		}
+	}
+
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		if (out[x].I)
+			scale(out[x].I, 1.0 / count, n);
+		if (out[x].Q)
+			scale(out[x].Q, 1.0 / count, n);
+	}
+	avg.sweeps = 0;
+	return ERR_OK;
+}
+
+// One sweep, blended into the running average. The weight is 1 / sweeps until
+// `count` sweeps have been seen, so the average settles as fast as a block
+// average would.
+static ErrCode exponentialAverage(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS],
+                                  unsigned int count, bool restart)
+{
+	ErrCode code = measureSweep(et, kind, out);
+	if (code != ERR_OK)
+		return code;
+
+	Averaging& avg = et->averaging;
+	size_t n = sweepPoints(et);
+	unsigned int mask = arrayMask(out);
+	if (restart || avg.kind != kind || avg.points != n || avg.mask != mask)
+	{
+		avg.sweeps = 0;
+		avg.kind = kind;
+		avg.points = n;
+		avg.mask = mask;
+	}
+
+	// The average is linear, so I and Q are averaged independently and an
+	// output the caller only asked one half of needs no scratch for the other.
+	avg.sweeps = std::min(avg.sweeps + 1, count);
+	double weight = 1.0 / avg.sweeps;
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		if (out[x].I)
+		{
+			avg.i[x].resize(n);
+			blend(avg.i[x].data(), out[x].I, weight, n);
+		}
+		if (out[x].Q)
+		{
+			avg.q[x].resize(n);
+			blend(avg.q[x].data(), out[x].Q, weight, n);
+		}
+	}
+	return ERR_OK;
+}
+
+namespace vnaext
+{
+
+	ErrCode measureAveraged(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+	{
+		AverageMode mode;
+		unsigned int count;
+		bool restart;
+		{
+			std::lock_guard<std::mutex> guard(et->lock);
+			mode = et->averaging.mode;
+			count = et->averaging.count;
+			restart = et->averaging.restart;
+			et->averaging.restart = false;
+		}
+
+		if (mode == AVERAGE_BLOCK)
+			return blockAverage(et, kind, out, count);
+		if (mode == AVERAGE_EXPONENTIAL)
+			return exponentialAverage(et, kind, out, count, restart);
+		return measureSweep(et, kind, out);
+	}
+
+}
+
+ErrCode setAveraging(TaskHandle t, const AverageMode mode, const unsigned int N)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (mode != AVERAGE_OFF && mode != AVERAGE_BLOCK && mode != AVERAGE_EXPONENTIAL)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (mode != AVERAGE_OFF && N == 0)
+		return ERR_WRONG_PROGRAM_TYPE;
+
+	ExtTask* et = getExtTask(t);
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->averaging.mode = mode;
+	et->averaging.count = N;
+	et->averaging.restart = true;
+	return ERR_OK;
+}
+
+ErrCode restartAveraging(TaskHandle t)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->averaging.restart = true;
+	return ERR_OK;
+}
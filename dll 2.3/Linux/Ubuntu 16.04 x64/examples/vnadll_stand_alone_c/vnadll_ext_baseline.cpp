@@ -0,0 +1,161 @@
+// vnadll_ext_baseline.cpp : Background subtraction for uncalibrated sweeps.
+//
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+// out = in - background
+static void subtract(double* data, const double* background, size_t n)
+{
+	for (size_t x = 0; x < n; x += 1)
+		data[x] -= background[x];
+}
+
+// out = in - background; background += (in - background) * alpha
+static void subtractAndTrack(double* data, double* background, double alpha, size_t n)
+{
+	for (size_t x = 0; x < n; x += 1)
+	{
+		double diff = data[x] - background[x];
+		background[x] += diff * alpha;
+		data[x] = diff;
+	}
+}
+
+namespace vnaext
+{
+
+	ErrCode applyBaseline(ExtTask* et, const ComplexData out[NUM_OUTPUTS])
+	{
+		size_t n = sweepPoints(et);
+
+		// Borrow the background, so the subtraction below runs without `lock`
+		// held and cancelMeasurement() and the setters only wait for the swaps.
+		Baseline bl;
+		unsigned int generation;
+		{
+			std::lock_guard<std::mutex> guard(et->lock);
+			Baseline& current = et->baseline;
+			if (!current.active)
+				return ERR_OK;
+
+			if (n != current.points)
+			{
+				// A fixed background only fits the sweep it was taken on; an adaptive
+				// one starts over.
+				if (current.alpha == 0)
+					return ERR_MISSING_FREQS;
+				current.points = n;
+				for (int x = 0; x < NUM_OUTPUTS; x += 1)
+					current.valid[x] = false;
+			}
+
+			bl.alpha = current.alpha;
+			for (int x = 0; x < NUM_OUTPUTS; x += 1)
+			{
+				bl.valid[x] = current.valid[x];
+				bl.i[x].swap(current.i[x]);
+				bl.q[x].swap(current.q[x]);
+			}
+			generation = current.generation;
+		}
+
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			if (!out[x].I || !out[x].Q)
+				continue;
+			if (!bl.valid[x])
+			{
+				if (bl.alpha == 0)
+					continue;
+				bl.i[x].assign(out[x].I, out[x].I + n);
+				bl.q[x].assign(out[x].Q, out[x].Q + n);
+				bl.valid[x] = true;
+			}
+
+			if (bl.alpha == 0)
+			{
+				subtract(out[x].I, bl.i[x].data(), n);
+				subtract(out[x].Q, bl.q[x].data(), n);
+			}
+			else
+			{
+				subtractAndTrack(out[x].I, bl.i[x].data(), bl.alpha, n);
+				subtractAndTrack(out[x].Q, bl.q[x].data(), bl.alpha, n);
+			}
+		}
+
+		// Give it back, unless it was replaced or cleared in the meantime.
+		std::lock_guard<std::mutex> guard(et->lock);
+		Baseline& current = et->baseline;
+		if (current.generation == generation)
+		{
+			for (int x = 0; x < NUM_OUTPUTS; x += 1)
+			{
+				current.valid[x] = bl.valid[x];
+				current.i[x].swap(bl.i[x]);
+				current.q[x].swap(bl.q[x]);
+			}
+		}
+		return ERR_OK;
+	}
+
+}
+
+ErrCode setBaseline(TaskHandle t, const unsigned int N,
+                    ComplexData out0, ComplexData out1,
+                    ComplexData out2, ComplexData out3,
+                    ComplexData out4)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+	if (N == 0)
+		return ERR_MISSING_FREQS;
+
+	ComplexData in[NUM_OUTPUTS] = { out0, out1, out2, out3, out4 };
+	std::lock_guard<std::mutex> guard(et->lock);
+	Baseline& bl = et->baseline;
+	bl.active = true;
+	bl.points = N;
+	bl.generation += 1;
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		bl.valid[x] = in[x].I && in[x].Q;
+		if (!bl.valid[x])
+			continue;
+		bl.i[x].assign(in[x].I, in[x].I + N);
+		bl.q[x].assign(in[x].Q, in[x].Q + N);
+	}
+	return ERR_OK;
+}
+
+ErrCode setBaselineAdaptation(TaskHandle t, const double alpha)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+	if (!(alpha >= 0 && alpha <= 1))
+		return ERR_WRONG_PROGRAM_TYPE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	Baseline& bl = et->baseline;
+	bl.alpha = alpha;
+	if (alpha > 0)
+		bl.active = true;
+	return ERR_OK;
+}
+
+ErrCode clearBaseline(TaskHandle t)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	unsigned int generation = et->baseline.generation + 1;
+	et->baseline = Baseline();
+	et->baseline.generation = generation;
+	return ERR_OK;
+}
@@ -0,0 +1,153 @@
+// vnadll_ext_cal.cpp : Lazy, sweep-restricted factory calibration.
+//
+
+#include <algorithm>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+// Number of terms in the 12-term calibration model.
+static const int CAL_TERMS = 12;
+
+// Restrict the calibration of `t` to the points bracketing [lo, hi]. On success
+// the span actually covered by the kept points is returned in `kept_lo`/`kept_hi`.
+static ErrCode restrictCalibration(TaskHandle t, double lo, double hi, double* kept_lo, double* kept_hi)
+{
+	size_t n = getCalibrationNumberOfFrequencies(t);
+	const double* cal_f = getCalibrationFrequencies(t);
+	if (n == 0 || !cal_f)
+		return ERR_BAD_CAL;
+
+	// Calibration frequencies are ascending.
+	size_t first = std::upper_bound(cal_f, cal_f + n, lo) - cal_f;
+	first = first > 0 ? first - 1 : 0;
+	size_t last = std::lower_bound(cal_f, cal_f + n, hi) - cal_f;
+	last = std::min(last, n - 1);
+	if (last == first)
+	{
+		if (last + 1 < n)
+			last += 1;
+		else if (first > 0)
+			first -= 1;
+	}
+
+	*kept_lo = cal_f[first];
+	*kept_hi = cal_f[last];
+	if (first == 0 && last == n - 1)
+		return ERR_OK;
+
+	std::vector<double> freqs(cal_f + first, cal_f + last + 1);
+	std::vector<double> terms(2 * CAL_TERMS * n);
+	ComplexData e[CAL_TERMS];
+	for (int x = 0; x < CAL_TERMS; x += 1)
+	{
+		e[x].I = &terms[(2 * x + 0) * n];
+		e[x].Q = &terms[(2 * x + 1) * n];
+	}
+
+	ErrCode code = exportCalibration(t, e[0], e[1], e[2], e[3], e[4], e[5],
+	                                 e[6], e[7], e[8], e[9], e[10], e[11]);
+	if (code != ERR_OK)
+		return code;
+
+	for (int x = 0; x < CAL_TERMS; x += 1)
+	{
+		e[x].I += first;
+		e[x].Q += first;
+	}
+	return importCalibration(t, freqs.data(), (unsigned int)freqs.size(),
+	                         e[0], e[1], e[2], e[3], e[4], e[5],
+	                         e[6], e[7], e[8], e[9], e[10], e[11]);
+}
+
+// Check that the calibration of `t` is still the one ensureCalibration() left
+// there, which had `points` points from `lo` to `hi`.
+static bool calibrationUnchanged(TaskHandle t, size_t points, double lo, double hi)
+{
+	size_t n = getCalibrationNumberOfFrequencies(t);
+	const double* cal_f = getCalibrationFrequencies(t);
+	return n == points && cal_f && cal_f[0] == lo && cal_f[n - 1] == hi;
+}
+
+namespace vnaext
+{
+
+	ErrCode ensureCalibration(ExtTask* et)
+	{
+		TaskHandle t = et->handle;
+		bool factory_loaded;
+		size_t cal_points;
+		double kept_lo, kept_hi;
+		{
+			std::lock_guard<std::mutex> guard(et->lock);
+			if (!et->lazy_factory_cal)
+				return ERR_OK;
+			factory_loaded = et->factory_cal_loaded;
+			cal_points = et->cal_points;
+			kept_lo = et->cal_span_lo;
+			kept_hi = et->cal_span_hi;
+		}
+
+		double lo, hi;
+		if (!sweepSpan(et, &lo, &hi))
+			return ERR_MISSING_FREQS;
+
+		if (isCalibrationComplete(t))
+		{
+			// Caller-supplied calibrations are left alone, including one that
+			// replaced the factory calibration loaded here earlier.
+			if (factory_loaded && !calibrationUnchanged(t, cal_points, kept_lo, kept_hi))
+			{
+				std::lock_guard<std::mutex> guard(et->lock);
+				et->factory_cal_loaded = false;
+				return ERR_OK;
+			}
+			if (!factory_loaded || (lo >= kept_lo && hi <= kept_hi))
+				return ERR_OK;
+		}
+
+		if (!hasFactoryCalibration(t))
+			return ERR_BAD_CAL;
+
+		ErrCode code = importFactoryCalibration(t);
+		if (code == ERR_OK)
+			code = restrictCalibration(t, lo, hi, &kept_lo, &kept_hi);
+
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->factory_cal_loaded = code == ERR_OK;
+		et->cal_points = getCalibrationNumberOfFrequencies(t);
+		et->cal_span_lo = kept_lo;
+		et->cal_span_hi = kept_hi;
+		return code;
+	}
+
+}
+
+ErrCode setLazyFactoryCalibration(TaskHandle t, const bool enable)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->lazy_factory_cal = enable;
+	return ERR_OK;
+}
+
+ErrCode restrictCalibrationToSweep(TaskHandle t)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (getState(t) != TASK_STOPPED && getState(t) != TASK_STARTED)
+		return ERR_WRONG_STATE;
+	if (!isCalibrationComplete(t))
+		return ERR_BAD_CAL;
+
+	double lo, hi;
+	if (!sweepSpan(getExtTask(t), &lo, &hi))
+		return ERR_MISSING_FREQS;
+
+	double kept_lo, kept_hi;
+	return restrictCalibration(t, lo, hi, &kept_lo, &kept_hi);
+}
@@ -0,0 +1,213 @@
+// vnadll_ext_cw.cpp : Continuous-wave (zero-span) streaming into a sample ring.
+//
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+// Consecutive failed blocks tolerated before the stream stops with the error.
+static const int CW_MAX_RETRIES = 3;
+
+// Pause before retrying a failed block, multiplied by the number of failures.
+static const std::chrono::milliseconds CW_RETRY_BACKOFF(10);
+
+// Failures after which the next block may well succeed: a lost or late packet.
+static bool transientError(ErrCode code)
+{
+	return code == ERR_NO_RESPONSE || code == ERR_BYTES;
+}
+
+static void pushSample(CWStream& cw, const CWSample& sample)
+{
+	size_t capacity = cw.ring.size();
+	if (cw.count == capacity)
+	{
+		cw.head = (cw.head + 1) % capacity;
+		cw.count -= 1;
+		cw.dropped += 1;
+	}
+	cw.ring[(cw.head + cw.count) % capacity] = sample;
+	cw.count += 1;
+}
+
+// Runs on the io pool for as long as the stream is active. Every iteration is one
+// zero-span sweep; its samples are timestamped back from the completion time at
+// the hop rate and appended to the ring.
+static void runStream(ExtTask* et, unsigned int points)
+{
+	std::vector<double> buf_i[NUM_OUTPUTS];
+	std::vector<double> buf_q[NUM_OUTPUTS];
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		buf_i[x].resize(points);
+		buf_q[x].resize(points);
+	}
+
+	std::unique_lock<std::mutex> guard(et->lock);
+	CWStream& cw = et->cw;
+	int failures = 0;
+	while (!cw.stopping)
+	{
+		guard.unlock();
+		ComplexData out[NUM_OUTPUTS];
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			out[x].I = buf_i[x].data();
+			out[x].Q = buf_q[x].data();
+		}
+		ErrCode code = measureUncalibrated(et->handle, out[0], out[1], out[2], out[3], out[4]);
+		std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+		guard.lock();
+
+		if (code != ERR_OK)
+		{
+			if (cw.stopping)
+				break;
+			failures += 1;
+			if (!transientError(code) || failures > CW_MAX_RETRIES)
+			{
+				// Wake the reader, so it sees the error from readCWStream().
+				cw.error = code;
+				et->signalCompletion();
+				break;
+			}
+			// The block is lost; retry after a pause.
+			et->cv.wait_for(guard, CW_RETRY_BACKOFF * failures, [&cw] { return cw.stopping; });
+			continue;
+		}
+		failures = 0;
+
+		double end = std::chrono::duration<double>(finished - cw.origin).count();
+		CWSample sample;
+		sample.block = cw.blocks;
+		for (unsigned int n = 0; n < points; n += 1)
+		{
+			sample.timestamp_seconds = end - (points - 1 - n) / cw.rate;
+			for (int x = 0; x < NUM_OUTPUTS; x += 1)
+			{
+				sample.I[x] = buf_i[x][n];
+				sample.Q[x] = buf_q[x][n];
+			}
+			pushSample(cw, sample);
+		}
+		cw.blocks += 1;
+		et->signalCompletion();
+	}
+
+	cw.running = false;
+	et->in_flight = false;
+	et->cv.notify_all();
+}
+
+ErrCode startCWStream(TaskHandle t, const double freq, const unsigned int block_points,
+                      const unsigned int ring_samples)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (ring_samples == 0)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (getState(t) != TASK_STOPPED)
+		return ERR_WRONG_STATE;
+
+	HardwareDetails details = getHardwareDetails(t);
+	unsigned int points = block_points ? block_points : (unsigned int)details.maximum_points;
+	if (points == 0)
+		return ERR_WRONG_STATE;
+	if (points > (unsigned int)details.maximum_points)
+		return ERR_TOO_MANY_POINTS;
+
+	double rate = hopPointsPerSecond(getHopRate(t));
+	if (rate == 0)
+		return ERR_MISSING_HOP;
+
+	ExtTask* et = getExtTask(t);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		if (et->in_flight || et->submitted)
+			return ERR_WRONG_STATE;
+
+		double cw_freq = freq;
+		ErrCode code = utilNearestLegalFreq(t, &cw_freq);
+		if (code != ERR_OK)
+			return code;
+		std::vector<double> freqs(points, cw_freq);
+		et->plan = SweepPlan();
+		code = setFrequencies(t, freqs.data(), points);
+		if (code == ERR_OK)
+			code = start(t);
+		if (code != ERR_OK)
+			return code;
+
+		CWStream& cw = et->cw;
+		cw.ring.assign(ring_samples, CWSample());
+		cw.head = 0;
+		cw.count = 0;
+		cw.dropped = 0;
+		cw.blocks = 0;
+		cw.error = ERR_OK;
+		cw.rate = rate;
+		cw.origin = std::chrono::steady_clock::now();
+		cw.stopping = false;
+		cw.running = true;
+		et->in_flight = true;
+		et->drainCompletion();
+	}
+
+	ioPool().submit([et, points] { runStream(et, points); });
+	return ERR_OK;
+}
+
+ErrCode stopCWStream(TaskHandle t)
+{
+	ExtTask* et = findExtTask(t);
+	if (!et)
+		return ERR_WRONG_STATE;
+
+	std::unique_lock<std::mutex> guard(et->lock);
+	CWStream& cw = et->cw;
+	if (cw.running)
+	{
+		cw.stopping = true;
+		et->cv.notify_all();
+		interruptMeasurement(t);
+		et->cv.wait(guard, [&cw] { return !cw.running; });
+	}
+	else if (cw.error == ERR_OK)
+		return ERR_WRONG_STATE;
+
+	ErrCode code = cw.error;
+	cw.error = ERR_OK;
+	return code;
+}
+
+ErrCode readCWStream(TaskHandle t, CWSample* samples, const unsigned int max_samples,
+                     unsigned int* count, unsigned int* dropped)
+{
+	if (!samples || !count)
+		return ERR_WRONG_PROGRAM_TYPE;
+
+	ExtTask* et = findExtTask(t);
+	if (!et)
+		return ERR_WRONG_STATE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	CWStream& cw = et->cw;
+	if (cw.ring.empty())
+		return ERR_WRONG_STATE;
+
+	size_t n = cw.count < max_samples ? cw.count : max_samples;
+	for (size_t x = 0; x < n; x += 1)
+		samples[x] = cw.ring[(cw.head + x) % cw.ring.size()];
+	cw.head = (cw.head + n) % cw.ring.size();
+	cw.count -= n;
+
+	*count = (unsigned int)n;
+	if (dropped)
+		*dropped = cw.dropped;
+	cw.dropped = 0;
+	if (cw.count == 0)
+		et->drainCompletion();
+	if (n == 0 && !cw.running)
+		return cw.error;
+	return ERR_OK;
+}
@@ -0,0 +1,325 @@
+// vnadll_ext_deembed.cpp : Two-port network conversions and fixture de-embedding.
+//
+
+#include <math.h>
+
+#include "vnadll_ext_dsp.h"
+
+using namespace vnaext;
+
+NetworkFormat NETWORK_S    = 1;
+NetworkFormat NETWORK_T    = 2;
+NetworkFormat NETWORK_ABCD = 3;
+
+// Fixture frequencies and sweep frequencies closer than this, in MHz, match.
+static const double FIXTURE_FREQ_TOLERANCE = 1e-6;
+
+// A fixture with |S21| below this does not transmit and cannot be removed.
+static const double MIN_FIXTURE_TRANSMISSION = 1e-12;
+
+// 2x2 complex matrix, in the element order of the API: 11, 21, 12, 22.
+struct Matrix2
+{
+	cplx m11, m21, m12, m22;
+};
+
+static Matrix2 multiply(const Matrix2& a, const Matrix2& b)
+{
+	Matrix2 r;
+	r.m11 = a.m11 * b.m11 + a.m12 * b.m21;
+	r.m21 = a.m21 * b.m11 + a.m22 * b.m21;
+	r.m12 = a.m11 * b.m12 + a.m12 * b.m22;
+	r.m22 = a.m21 * b.m12 + a.m22 * b.m22;
+	return r;
+}
+
+static Matrix2 inverse(const Matrix2& a)
+{
+	cplx det = a.m11 * a.m22 - a.m12 * a.m21;
+	Matrix2 r;
+	r.m11 = a.m22 / det;
+	r.m21 = -a.m21 / det;
+	r.m12 = -a.m12 / det;
+	r.m22 = a.m11 / det;
+	return r;
+}
+
+// T-parameters with [b1; a1] = T [a2; b2], so cascading is a matrix product.
+static Matrix2 sToT(const Matrix2& s)
+{
+	cplx det = s.m11 * s.m22 - s.m12 * s.m21;
+	Matrix2 t;
+	t.m11 = -det / s.m21;
+	t.m12 = s.m11 / s.m21;
+	t.m21 = -s.m22 / s.m21;
+	t.m22 = 1.0 / s.m21;
+	return t;
+}
+
+static Matrix2 tToS(const Matrix2& t)
+{
+	cplx det = t.m11 * t.m22 - t.m12 * t.m21;
+	Matrix2 s;
+	s.m11 = t.m12 / t.m22;
+	s.m21 = 1.0 / t.m22;
+	s.m12 = det / t.m22;
+	s.m22 = -t.m21 / t.m22;
+	return s;
+}
+
+static Matrix2 sToAbcd(const Matrix2& s, double z0)
+{
+	cplx den = 2.0 * s.m21;
+	cplx cross = s.m12 * s.m21;
+	Matrix2 a;
+	a.m11 = ((1.0 + s.m11) * (1.0 - s.m22) + cross) / den;
+	a.m12 = z0 * ((1.0 + s.m11) * (1.0 + s.m22) - cross) / den;
+	a.m21 = ((1.0 - s.m11) * (1.0 - s.m22) - cross) / (den * z0);
+	a.m22 = ((1.0 - s.m11) * (1.0 + s.m22) + cross) / den;
+	return a;
+}
+
+static Matrix2 abcdToS(const Matrix2& a, double z0)
+{
+	cplx b = a.m12 / z0;
+	cplx c = a.m21 * z0;
+	cplx den = a.m11 + b + c + a.m22;
+	Matrix2 s;
+	s.m11 = (a.m11 + b - c - a.m22) / den;
+	s.m21 = 2.0 / den;
+	s.m12 = 2.0 * (a.m11 * a.m22 - a.m12 * a.m21) / den;
+	s.m22 = (-a.m11 + b - c + a.m22) / den;
+	return s;
+}
+
+static Matrix2 load(const ComplexData* in, size_t n)
+{
+	Matrix2 m;
+	m.m11 = cplx(in[0].I[n], in[0].Q[n]);
+	m.m21 = cplx(in[1].I[n], in[1].Q[n]);
+	m.m12 = cplx(in[2].I[n], in[2].Q[n]);
+	m.m22 = cplx(in[3].I[n], in[3].Q[n]);
+	return m;
+}
+
+static void store(const Matrix2& m, const ComplexData* out, size_t n)
+{
+	out[0].I[n] = m.m11.real(); out[0].Q[n] = m.m11.imag();
+	out[1].I[n] = m.m21.real(); out[1].Q[n] = m.m21.imag();
+	out[2].I[n] = m.m12.real(); out[2].Q[n] = m.m12.imag();
+	out[3].I[n] = m.m22.real(); out[3].Q[n] = m.m22.imag();
+}
+
+static bool validFormat(NetworkFormat format)
+{
+	return format == NETWORK_S || format == NETWORK_T || format == NETWORK_ABCD;
+}
+
+static bool validTwoPort(const ComplexData* data)
+{
+	if (!data)
+		return false;
+	for (int x = 0; x < 4; x += 1)
+		if (!data[x].I || !data[x].Q)
+			return false;
+	return true;
+}
+
+namespace vnaext
+{
+
+	// Inverse fixture networks of a Task, one entry per frequency, with the
+	// port extensions folded in.
+	struct DeembedPlan
+	{
+		std::vector<double> freqs;
+		std::vector<Matrix2> port1;  // (T_fixture1 T_line1)^-1
+		std::vector<Matrix2> port2;  // (T_line2 T_fixture2)^-1
+		std::vector<cplx>    det;    // det(port1) det(port2)
+	};
+
+	// De-embed one sweep. The measured T-matrix is used scaled by S21, which
+	// cancels out of the result, so a DUT that does not transmit is still fine.
+	static void deembedSweep(const DeembedPlan& plan, const ComplexData* in, const ComplexData* out)
+	{
+		size_t N = plan.freqs.size();
+		for (size_t n = 0; n < N; n += 1)
+		{
+			Matrix2 s = load(in, n);
+
+			Matrix2 u;
+			u.m11 = s.m12 * s.m21 - s.m11 * s.m22;
+			u.m12 = s.m11;
+			u.m21 = -s.m22;
+			u.m22 = 1.0;
+			Matrix2 m = multiply(multiply(plan.port1[n], u), plan.port2[n]);
+
+			Matrix2 r;
+			r.m11 = m.m12 / m.m22;
+			r.m21 = s.m21 / m.m22;
+			r.m12 = plan.det[n] * s.m12 / m.m22;
+			r.m22 = -m.m21 / m.m22;
+			store(r, out, n);
+		}
+	}
+
+	static bool matchesSweep(ExtTask* et, const DeembedPlan& plan)
+	{
+		std::vector<double> freqs;
+		if (et->plan.active)
+			freqs = et->plan.freqs;
+		else
+		{
+			freqs.resize(getNumberOfFrequencies(et->handle));
+			getFrequencies(et->handle, freqs.data(), (int)freqs.size());
+		}
+
+		if (freqs.size() != plan.freqs.size())
+			return false;
+		for (size_t n = 0; n < freqs.size(); n += 1)
+			if (fabs(freqs[n] - plan.freqs[n]) > FIXTURE_FREQ_TOLERANCE)
+				return false;
+		return true;
+	}
+
+	ErrCode applyDeembedding(ExtTask* et, const ComplexData out[NUM_OUTPUTS])
+	{
+		std::shared_ptr<const DeembedPlan> plan;
+		{
+			std::lock_guard<std::mutex> guard(et->lock);
+			plan = et->deembed;
+		}
+		if (!plan)
+			return ERR_OK;
+		if (!matchesSweep(et, *plan))
+			return ERR_MISSING_FREQS;
+
+		deembedSweep(*plan, out, out);
+		return ERR_OK;
+	}
+
+}
+
+ErrCode convertTwoPort(const unsigned int N, const ComplexData* in,
+                       const NetworkFormat from, const NetworkFormat to,
+                       const double z0, ComplexData* out)
+{
+	if (!validTwoPort(in) || !validTwoPort(out) || !validFormat(from) || !validFormat(to))
+		return ERR_WRONG_PROGRAM_TYPE;
+
+	for (unsigned int n = 0; n < N; n += 1)
+	{
+		Matrix2 m = load(in, n);
+		if (from != to)
+		{
+			// Everything converts through S.
+			if (from == NETWORK_T)
+				m = tToS(m);
+			else if (from == NETWORK_ABCD)
+				m = abcdToS(m, z0);
+
+			if (to == NETWORK_T)
+				m = sToT(m);
+			else if (to == NETWORK_ABCD)
+				m = sToAbcd(m, z0);
+		}
+		store(m, out, n);
+	}
+	return ERR_OK;
+}
+
+ErrCode setDeembedding(TaskHandle t, const double* freqs, const unsigned int N,
+                       const ComplexData* port1_fixture, const ComplexData* port2_fixture,
+                       const double port1_delay, const double port2_delay)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (!freqs || N == 0)
+		return ERR_MISSING_FREQS;
+	if ((port1_fixture && !validTwoPort(port1_fixture)) || (port2_fixture && !validTwoPort(port2_fixture)))
+		return ERR_WRONG_PROGRAM_TYPE;
+
+	std::shared_ptr<DeembedPlan> plan(new DeembedPlan);
+	plan->freqs.assign(freqs, freqs + N);
+	plan->port1.resize(N);
+	plan->port2.resize(N);
+	plan->det.resize(N);
+
+	Matrix2 identity;
+	identity.m11 = identity.m22 = 1.0;
+	identity.m12 = identity.m21 = 0.0;
+
+	for (unsigned int n = 0; n < N; n += 1)
+	{
+		// Inverse of a matched line of delay tau is diag(e^(j w tau), e^(-j w tau)).
+		double w = 2 * M_PI * freqs[n] * 1e6;
+		Matrix2 line1 = identity;
+		line1.m11 = std::polar(1.0, w * port1_delay);
+		line1.m22 = std::polar(1.0, -w * port1_delay);
+		Matrix2 line2 = identity;
+		line2.m11 = std::polar(1.0, w * port2_delay);
+		line2.m22 = std::polar(1.0, -w * port2_delay);
+
+		Matrix2 fixture1 = identity;
+		Matrix2 fixture2 = identity;
+		if (port1_fixture)
+		{
+			Matrix2 s = load(port1_fixture, n);
+			if (std::abs(s.m21) < MIN_FIXTURE_TRANSMISSION)
+				return ERR_BAD_CAL;
+			fixture1 = inverse(sToT(s));
+		}
+		if (port2_fixture)
+		{
+			Matrix2 s = load(port2_fixture, n);
+			if (std::abs(s.m21) < MIN_FIXTURE_TRANSMISSION)
+				return ERR_BAD_CAL;
+			fixture2 = inverse(sToT(s));
+		}
+
+		Matrix2& p1 = plan->port1[n];
+		Matrix2& p2 = plan->port2[n];
+		p1 = multiply(line1, fixture1);
+		p2 = multiply(fixture2, line2);
+		plan->det[n] = (p1.m11 * p1.m22 - p1.m12 * p1.m21) * (p2.m11 * p2.m22 - p2.m12 * p2.m21);
+	}
+
+	ExtTask* et = getExtTask(t);
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->deembed = plan;
+	return ERR_OK;
+}
+
+ErrCode clearDeembedding(TaskHandle t)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->deembed.reset();
+	return ERR_OK;
+}
+
+ErrCode deembedSweeps(TaskHandle t, const ComplexData* in, const unsigned int sweeps, ComplexData* out)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+	if (!in || !out)
+		return ERR_WRONG_PROGRAM_TYPE;
+	for (unsigned int x = 0; x < sweeps; x += 1)
+		if (!validTwoPort(in + 4 * x) || !validTwoPort(out + 4 * x))
+			return ERR_WRONG_PROGRAM_TYPE;
+
+	std::shared_ptr<const DeembedPlan> plan;
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		plan = et->deembed;
+	}
+	if (!plan)
+		return ERR_WRONG_STATE;
+
+	parallelFor(sweeps, [&](size_t x) { deembedSweep(*plan, in + 4 * x, out + 4 * x); });
+	return ERR_OK;
+}
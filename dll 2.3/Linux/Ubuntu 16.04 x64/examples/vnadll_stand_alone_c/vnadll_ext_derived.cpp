@@ -0,0 +1,145 @@
+// vnadll_ext_derived.cpp : Derived quantities (log-magnitude, phase, group delay,
+// VSWR, impedance) computed in a single pass over a trace.
+//
+
+#include <math.h>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+static bool wantsAny(const DerivedQuantities* q)
+{
+	return q->log_magnitude || q->phase || q->group_delay || q->vswr || q->resistance || q->reactance;
+}
+
+// One pass over `in`. Group delay at point n needs the unwrapped phase of n + 1,
+// so it is written one point behind.
+static void computeTrace(const double* freqs, unsigned int N, const double* re, const double* im,
+                         double z0, const DerivedQuantities* q)
+{
+	bool need_phase = q->phase || q->group_delay;
+	bool need_mag = q->vswr;
+	bool need_z = q->resistance || q->reactance;
+
+	double unwrapped = 0;
+	double prev_raw = 0;
+	double prev_phase = 0;
+	double prev_prev_phase = 0;
+
+	for (unsigned int n = 0; n < N; n += 1)
+	{
+		double i = re[n];
+		double qv = im[n];
+		double power = i * i + qv * qv;
+
+		if (q->log_magnitude)
+			q->log_magnitude[n] = 10 * log10(power);
+
+		if (need_mag)
+		{
+			double mag = sqrt(power);
+			q->vswr[n] = mag < 1 ? (1 + mag) / (1 - mag) : INFINITY;
+		}
+
+		if (need_z)
+		{
+			// Z = z0 (1 + G) / (1 - G)
+			double dr = 1 - i;
+			double den = dr * dr + qv * qv;
+			double zr = den > 0 ? z0 * (1 - power) / den : INFINITY;
+			double zx = den > 0 ? z0 * 2 * qv / den : INFINITY;
+			if (q->resistance)
+				q->resistance[n] = zr;
+			if (q->reactance)
+				q->reactance[n] = zx;
+		}
+
+		if (need_phase)
+		{
+			double raw = atan2(qv, i);
+			if (n > 0)
+			{
+				double step = raw - prev_raw;
+				step -= 2 * M_PI * nearbyint(step / (2 * M_PI));
+				unwrapped += step;
+			}
+			else
+				unwrapped = raw;
+			prev_raw = raw;
+
+			if (q->phase)
+				q->phase[n] = unwrapped * 180 / M_PI;
+
+			// tau = -d(phase) / d(omega), central difference inside the sweep
+			if (q->group_delay && n >= 2)
+				q->group_delay[n - 1] = -(unwrapped - prev_prev_phase) / (2 * M_PI * (freqs[n] - freqs[n - 2]) * 1e6);
+			if (q->group_delay && n == 1)
+				q->group_delay[0] = -(unwrapped - prev_phase) / (2 * M_PI * (freqs[1] - freqs[0]) * 1e6);
+
+			prev_prev_phase = prev_phase;
+			prev_phase = unwrapped;
+		}
+	}
+
+	if (q->group_delay)
+	{
+		if (N >= 2)
+			q->group_delay[N - 1] = -(prev_phase - prev_prev_phase) / (2 * M_PI * (freqs[N - 1] - freqs[N - 2]) * 1e6);
+		else if (N == 1)
+			q->group_delay[0] = 0;
+	}
+}
+
+ErrCode computeDerivedQuantities(const double* freqs, const unsigned int N, ComplexData in,
+                                 const double z0, const DerivedQuantities* out)
+{
+	if (!out || !in.I || !in.Q)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (out->group_delay && !freqs)
+		return ERR_MISSING_FREQS;
+
+	computeTrace(freqs, N, in.I, in.Q, z0, out);
+	return ERR_OK;
+}
+
+ErrCode measureDerived(TaskHandle t, const MeasurementKind kind, const unsigned int output,
+                       const double z0, const DerivedQuantities* out)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (kind != MEAS_UNCALIBRATED && kind != MEAS_2PORT_CALIBRATED)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (!out || !wantsAny(out))
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (output >= (unsigned int)(kind == MEAS_2PORT_CALIBRATED ? 4 : NUM_OUTPUTS))
+		return ERR_BAD_PATH;
+
+	ExtTask* et = getExtTask(t);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		if (et->in_flight || et->submitted || et->pipeline)
+			return ERR_WRONG_STATE;
+		et->in_flight = true;
+		et->points = sweepPoints(et);
+	}
+
+	// Measure into the Task's own buffers and derive straight from them, while
+	// the data is still in cache.
+	ComplexData bufs[NUM_OUTPUTS];
+	bindBuffers(et, bufs);
+	if (kind == MEAS_2PORT_CALIBRATED)
+		bufs[4].I = bufs[4].Q = NULL;
+	ErrCode code = measureInto(et, kind, bufs);
+	if (code == ERR_OK)
+	{
+		std::vector<double> freqs(et->points);
+		getSegmentedFrequencies(t, freqs.data(), et->points);
+		computeTrace(freqs.data(), et->points, bufs[output].I, bufs[output].Q, z0, out);
+	}
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->in_flight = false;
+	et->cv.notify_all();
+	return code;
+}
@@ -0,0 +1,221 @@
+// vnadll_ext_doppler.cpp : Slow-time (sweep to sweep) Doppler processing.
+//
+
+#include <algorithm>
+
+#include "vnadll_ext_dsp.h"
+
+using namespace vnaext;
+
+namespace vnaext
+{
+
+	// Doppler state of a Task. Shared with the compute pool job processing the
+	// last block, so the job never needs the Task itself.
+	struct DopplerState
+	{
+		DopplerState() : doppler_bins(0), range_bins(0), filled(0), first_seconds(0), last_seconds(0),
+		                 busy(false), info(), ready(false), dropped(0), sequence(0) {}
+
+		DopplerConfig            config;
+		size_t                   doppler_bins;
+		std::vector<double>      window;   // slow-time window, one value per sweep
+		std::shared_ptr<FftPlan> fft;
+		std::chrono::steady_clock::time_point origin;
+
+		// Block being filled, [range bin][sweep]. Only touched by the thread
+		// that owns `in_flight` on the Task.
+		size_t                   range_bins;
+		unsigned int             filled;
+		std::vector<cplx>        block;
+		double                   first_seconds;
+		double                   last_seconds;
+
+		// Everything below is guarded by `lock`.
+		std::mutex               lock;
+		bool                     busy;     // a job is processing `work`
+		std::vector<cplx>        work;     // block handed to the job
+		std::vector<cplx>        pending;  // map being computed by the job
+		std::vector<cplx>        map;      // latest complete map, [range bin][Doppler bin]
+		DopplerMapInfo           info;
+		bool                     ready;
+		unsigned int             dropped;  // blocks discarded since the last map was read
+		unsigned int             sequence;
+	};
+
+	// Window, transform and center every range bin of `work` into `pending`.
+	// Runs on the compute pool with `busy` set, so it owns both buffers.
+	static void processBlock(std::shared_ptr<DopplerState> state, size_t range_bins,
+	                         double first_seconds, double last_seconds)
+	{
+		DopplerState& s = *state;
+		unsigned int sweeps = s.config.sweeps;
+		size_t D = s.doppler_bins;
+		s.pending.resize(range_bins * D);
+
+		for (size_t r = 0; r < range_bins; r += 1)
+		{
+			const cplx* in = s.work.data() + r * sweeps;
+			cplx* row = s.pending.data() + r * D;
+			for (unsigned int m = 0; m < sweeps; m += 1)
+				row[m] = in[m] * s.window[m];
+			std::fill(row + sweeps, row + D, cplx(0, 0));
+			s.fft->forward(row);
+
+			// Zero Doppler to the middle: bins run from -rate / 2 to rate / 2.
+			std::rotate(row, row + D / 2, row + D);
+		}
+
+		std::lock_guard<std::mutex> guard(s.lock);
+		s.map.swap(s.pending);
+		s.sequence += 1;
+		s.info.sequence = s.sequence;
+		s.info.range_bins = (unsigned int)range_bins;
+		s.info.doppler_bins = (unsigned int)D;
+		s.info.first_sweep_seconds = first_seconds;
+		s.info.sweep_rate = sweeps > 1 && last_seconds > first_seconds
+		                    ? (sweeps - 1) / (last_seconds - first_seconds) : 0;
+		s.ready = true;
+		s.busy = false;
+	}
+
+	void feedDoppler(ExtTask* et, const ComplexData out[NUM_OUTPUTS])
+	{
+		std::shared_ptr<DopplerState> state;
+		{
+			std::lock_guard<std::mutex> guard(et->lock);
+			state = et->doppler;
+		}
+		if (!state)
+			return;
+
+		DopplerState& s = *state;
+		const ComplexData& in = out[s.config.output];
+		if (!in.I || !in.Q)
+			return;
+
+		double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - s.origin).count();
+		size_t range_bins = resultPoints(et);
+		unsigned int sweeps = s.config.sweeps;
+		if (range_bins != s.range_bins)
+		{
+			// The sweep changed; start a new block.
+			s.range_bins = range_bins;
+			s.filled = 0;
+			s.block.resize(range_bins * sweeps);
+		}
+
+		// Corner turn: sweep m becomes column m, so each range bin's slow-time
+		// series is contiguous for the transform.
+		unsigned int m = s.filled;
+		cplx* block = s.block.data();
+		for (size_t r = 0; r < range_bins; r += 1)
+			block[r * sweeps + m] = cplx(in.I[r], in.Q[r]);
+		if (m == 0)
+			s.first_seconds = now;
+		s.last_seconds = now;
+		s.filled += 1;
+		if (s.filled < sweeps)
+			return;
+
+		s.filled = 0;
+		{
+			std::lock_guard<std::mutex> guard(s.lock);
+			if (s.busy)
+			{
+				// The previous block is still being processed; drop this one
+				// rather than stall acquisition.
+				s.dropped += 1;
+				return;
+			}
+			s.busy = true;
+			s.work.swap(s.block);
+			s.block.resize(range_bins * sweeps);
+		}
+
+		double first = s.first_seconds;
+		double last = s.last_seconds;
+		computePool().submit([state, range_bins, first, last] { processBlock(state, range_bins, first, last); });
+	}
+
+}
+
+ErrCode startDoppler(TaskHandle t, const DopplerConfig* config)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+	if (!config || config->sweeps == 0)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (config->output >= (unsigned int)NUM_OUTPUTS)
+		return ERR_BAD_PATH;
+	if (config->doppler_points != 0
+	    && (nextPowerOfTwo(config->doppler_points) != config->doppler_points || config->doppler_points < config->sweeps))
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (!validWindow(config->window))
+		return ERR_WRONG_PROGRAM_TYPE;
+
+	std::shared_ptr<DopplerState> state(new DopplerState);
+	state->config = *config;
+	state->doppler_bins = config->doppler_points ? config->doppler_points : nextPowerOfTwo(config->sweeps);
+	state->window.resize(config->sweeps);
+	for (unsigned int m = 0; m < config->sweeps; m += 1)
+		state->window[m] = windowValue(config->window, config->window_parameter,
+		                               config->sweeps > 1 ? (double)m / (config->sweeps - 1) : 0.5);
+	state->fft.reset(new FftPlan(state->doppler_bins));
+	state->origin = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (et->in_flight || et->submitted)
+		return ERR_WRONG_STATE;
+	et->doppler = state;
+	return ERR_OK;
+}
+
+ErrCode stopDoppler(TaskHandle t)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (!et->doppler)
+		return ERR_WRONG_STATE;
+	et->doppler.reset();
+	return ERR_OK;
+}
+
+ErrCode getDopplerMap(TaskHandle t, ComplexData map, DopplerMapInfo* info)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::shared_ptr<DopplerState> state;
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		state = et->doppler;
+	}
+	if (!state)
+		return ERR_WRONG_STATE;
+
+	DopplerState& s = *state;
+	std::lock_guard<std::mutex> guard(s.lock);
+	if (!s.ready)
+		return ERR_WRONG_STATE;
+
+	for (size_t x = 0; x < s.map.size(); x += 1)
+	{
+		if (map.I)
+			map.I[x] = s.map[x].real();
+		if (map.Q)
+			map.Q[x] = s.map[x].imag();
+	}
+	if (info)
+	{
+		*info = s.info;
+		info->dropped = s.dropped;
+	}
+	s.dropped = 0;
+	return ERR_OK;
+}
@@ -0,0 +1,132 @@
+// vnadll_ext_dsp.h : Signal processing building blocks for the host-side VNA
+// extensions. Not part of the public API; only included by the vnadll_ext_*.cpp files.
+
+#ifndef __AKELA_VNA_EXT_DSP_HEADER
+#define __AKELA_VNA_EXT_DSP_HEADER
+
+#include <complex>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vnadll_ext_internal.h"
+
+namespace vnaext
+{
+
+	typedef std::complex<double> cplx;
+
+	// In-place radix-2 FFT of a fixed power-of-two size. Twiddles are computed
+	// once, so a plan can be shared by any number of threads.
+	class FftPlan
+	{
+	public:
+		explicit FftPlan(size_t n);
+
+		size_t size() const { return n; }
+
+		// X[k] = sum x[n] e^(-j 2 pi n k / N)
+		void forward(cplx* data) const;
+		// x[n] = sum X[k] e^(+j 2 pi n k / N), not scaled by 1/N
+		void inverse(cplx* data) const;
+
+	private:
+		void transform(cplx* data, bool inverse) const;
+
+		size_t              n;
+		std::vector<cplx>   twiddle;  // e^(-j 2 pi k / N), k < N / 2
+		std::vector<size_t> reversed; // bit-reversal permutation
+	};
+
+	// Smallest power of two that is >= n.
+	size_t nextPowerOfTwo(size_t n);
+
+	// True if `window` is one of the \ref WindowType values.
+	bool validWindow(WindowType window);
+
+	// Value of window `window` at `x` in [0, 1], 1 at the center.
+	double windowValue(WindowType window, double parameter, double x);
+
+	// Chirp-Z transform evaluating
+	//     out[m] = sum_n in[n] * z^(n m),   z = e^(j a),   0 <= n < n_in, 0 <= m < n_out
+	// with Bluestein's algorithm. `pre` and `post` scale the input and output, so
+	// windows and fixed phase terms cost nothing extra per trace.
+	class ChirpZ
+	{
+	public:
+		ChirpZ(size_t n_in, size_t n_out, double a,
+		       const std::vector<cplx>& pre, const std::vector<cplx>& post);
+
+		size_t inputSize() const { return n_in; }
+		size_t outputSize() const { return n_out; }
+
+		// `scratch` is resized as needed; use one per thread.
+		void run(const cplx* in, cplx* out, std::vector<cplx>& scratch) const;
+
+	private:
+		size_t            n_in;
+		size_t            n_out;
+		FftPlan           fft;
+		std::vector<cplx> pre;     // pre[n] * chirp(n)
+		std::vector<cplx> post;    // post[m] * chirp(m) / L
+		std::vector<cplx> kernel;  // FFT of the conjugate chirp
+	};
+
+	// rec = 1 / ref, point by point, with split real and imaginary arrays. Points
+	// where Ref has (numerically) no power get 0.
+	void referenceReciprocal(const double* ref_i, const double* ref_q, double* rec_i, double* rec_q, size_t n);
+
+	// (i, q) *= (rec_i, rec_q), point by point.
+	void multiplyComplex(double* i, double* q, const double* rec_i, const double* rec_q, size_t n);
+
+	// Small LRU cache of immutable plans. `Key` needs operator==; `build` is called
+	// outside the lock, so two threads missing on the same key may both build it.
+	template <class Key, class Plan>
+	class PlanCache
+	{
+	public:
+		explicit PlanCache(size_t capacity) : capacity(capacity) {}
+
+		std::shared_ptr<const Plan> find(const Key& key, const std::function<std::shared_ptr<const Plan>(const Key&)>& build)
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				for (typename Entries::iterator it = entries.begin(); it != entries.end(); ++it)
+				{
+					if (it->first == key)
+					{
+						entries.splice(entries.begin(), entries, it);
+						return entries.front().second;
+					}
+				}
+			}
+
+			std::shared_ptr<const Plan> plan = build(key);
+
+			std::lock_guard<std::mutex> guard(lock);
+			entries.push_front(std::make_pair(key, plan));
+			if (entries.size() > capacity)
+				entries.pop_back();
+			return plan;
+		}
+
+	private:
+		typedef std::list<std::pair<Key, std::shared_ptr<const Plan> > > Entries;
+
+		std::mutex lock;
+		Entries    entries;
+		size_t     capacity;
+	};
+
+	// Pool for the compute-bound post-processing, one thread per core.
+	WorkerPool& computePool();
+
+	// Run fn(0) .. fn(count - 1) on the compute pool and the calling thread, and
+	// wait for all of them. Must not be called from a compute pool job.
+	void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+}
+
+#endif
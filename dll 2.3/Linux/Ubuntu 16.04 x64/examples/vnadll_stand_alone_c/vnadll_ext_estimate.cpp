@@ -0,0 +1,95 @@
+// vnadll_ext_estimate.cpp : Sweep duration and capacity estimates.
+//
+
+#include <math.h>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+// Modelled payload sizes, see the SweepEstimate documentation.
+static const double BYTES_PER_SAMPLE       = 8;  // I and Q, 32 bits each, per path per point
+static const double BYTES_PER_PROGRAM_WORD = 4;
+
+double vnaext::hopPointsPerSecond(HopRate hop)
+{
+	if (hop == HOP_UNDEFINED) return 0;
+	if (hop == HOP_45K) return 45000;
+	if (hop == HOP_30K) return 30000;
+	if (hop == HOP_15K) return 15000;
+	if (hop == HOP_7K)  return 7000;
+	if (hop == HOP_3K)  return 3000;
+	if (hop == HOP_2K)  return 2000;
+	if (hop == HOP_1K)  return 1000;
+	if (hop == HOP_550) return 550;
+	if (hop == HOP_312) return 312;
+	if (hop == HOP_156) return 156;
+	if (hop == HOP_78)  return 78;
+	if (hop == HOP_39)  return 39;
+	if (hop == HOP_20)  return 20;
+	if (hop == HOP_90K) return 90000;
+	return 0;
+}
+
+ErrCode estimateSweep(TaskHandle t, const double* freqs, const unsigned int N,
+                      HopRate hop, Attenuation atten, const unsigned int paths,
+                      SweepEstimate* estimate)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (!estimate)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (!freqs || N == 0)
+		return ERR_MISSING_FREQS;
+	if (paths == 0 || paths > (unsigned int)NUM_OUTPUTS)
+		return ERR_BAD_PATH;
+
+	HardwareDetails details = getHardwareDetails(t);
+	if (details.maximum_points == 0)
+		return ERR_WRONG_STATE;
+
+	if (hop == HOP_UNDEFINED)
+		hop = getHopRate(t);
+	double rate = hopPointsPerSecond(hop);
+	if (rate == 0)
+		return ERR_MISSING_HOP;
+	// The attenuator setting affects neither timing nor program size.
+	(void)atten;
+
+	for (unsigned int x = 0; x < N; x += 1)
+		if (freqs[x] < details.minimum_frequency || freqs[x] > details.maximum_frequency)
+			return ERR_FREQ_OUT_OF_BOUNDS;
+
+	// Count band switches in the order setSegmentedFrequencies() would program.
+	FrequencyOrder ordering = ORDER_AS_GIVEN;
+	if (ExtTask* et = findExtTask(t))
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		ordering = et->ordering;
+	}
+	std::vector<unsigned int> order = pointOrder(t, ordering, freqs, N);
+
+	unsigned int switches = 0;
+	int band = bandOf(details, freqs[order.empty() ? 0 : order[0]]);
+	for (unsigned int x = 1; x < N; x += 1)
+	{
+		int next = bandOf(details, freqs[order.empty() ? x : order[x]]);
+		if (next != band)
+			switches += 1;
+		band = next;
+	}
+
+	unsigned int programs = (N + details.maximum_points - 1) / details.maximum_points;
+
+	estimate->points                  = N;
+	estimate->programs                = programs;
+	estimate->program_words_used      = programs > 1 ? details.maximum_points : N;
+	estimate->program_words_available = details.maximum_points;
+	estimate->band_switches           = switches;
+	estimate->points_per_second       = rate;
+	estimate->sweep_seconds           = N / rate;
+	estimate->program_bytes           = N * BYTES_PER_PROGRAM_WORD;
+	estimate->data_bytes              = (double)N * paths * BYTES_PER_SAMPLE;
+	estimate->bytes_on_wire           = estimate->data_bytes + (programs > 1 ? estimate->program_bytes : 0);
+	return ERR_OK;
+}
@@ -0,0 +1,190 @@
+// vnadll_ext_fft.cpp : FFT, chirp-Z, windows and the compute pool.
+//
+
+#include <math.h>
+
+#include "vnadll_ext_dsp.h"
+
+namespace vnaext
+{
+
+	FftPlan::FftPlan(size_t n)
+		: n(n)
+		, twiddle(n / 2)
+		, reversed(n)
+	{
+		for (size_t k = 0; k < n / 2; k += 1)
+			twiddle[k] = std::polar(1.0, -2 * M_PI * k / n);
+
+		int bits = 0;
+		while (((size_t)1 << bits) < n)
+			bits += 1;
+		for (size_t k = 0; k < n; k += 1)
+		{
+			size_t r = 0;
+			for (int b = 0; b < bits; b += 1)
+				if (k & ((size_t)1 << b))
+					r |= (size_t)1 << (bits - 1 - b);
+			reversed[k] = r;
+		}
+	}
+
+	void FftPlan::forward(cplx* data) const
+	{
+		transform(data, false);
+	}
+
+	void FftPlan::inverse(cplx* data) const
+	{
+		transform(data, true);
+	}
+
+	void FftPlan::transform(cplx* data, bool inverse) const
+	{
+		for (size_t k = 0; k < n; k += 1)
+			if (k < reversed[k])
+				std::swap(data[k], data[reversed[k]]);
+
+		for (size_t len = 2; len <= n; len <<= 1)
+		{
+			size_t half = len / 2;
+			size_t stride = n / len;
+			for (size_t base = 0; base < n; base += len)
+			{
+				for (size_t k = 0; k < half; k += 1)
+				{
+					cplx w = twiddle[k * stride];
+					if (inverse)
+						w = std::conj(w);
+					cplx a = data[base + k];
+					cplx b = data[base + k + half] * w;
+					data[base + k] = a + b;
+					data[base + k + half] = a - b;
+				}
+			}
+		}
+	}
+
+	size_t nextPowerOfTwo(size_t n)
+	{
+		size_t p = 1;
+		while (p < n)
+			p <<= 1;
+		return p;
+	}
+
+	// Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+	static double besselI0(double x)
+	{
+		double sum = 1;
+		double term = 1;
+		for (int k = 1; k < 50; k += 1)
+		{
+			term *= (x / (2 * k)) * (x / (2 * k));
+			sum += term;
+			if (term < sum * 1e-16)
+				break;
+		}
+		return sum;
+	}
+
+	bool validWindow(WindowType window)
+	{
+		return window == WINDOW_RECT || window == WINDOW_HANN || window == WINDOW_HAMMING
+		       || window == WINDOW_BLACKMAN || window == WINDOW_KAISER;
+	}
+
+	double windowValue(WindowType window, double parameter, double x)
+	{
+		if (window == WINDOW_HANN)
+			return 0.5 - 0.5 * cos(2 * M_PI * x);
+		if (window == WINDOW_HAMMING)
+			return 0.54 - 0.46 * cos(2 * M_PI * x);
+		if (window == WINDOW_BLACKMAN)
+			return 0.42 - 0.5 * cos(2 * M_PI * x) + 0.08 * cos(4 * M_PI * x);
+		if (window == WINDOW_KAISER)
+		{
+			double r = 2 * x - 1;
+			return besselI0(parameter * sqrt(fmax(0.0, 1 - r * r))) / besselI0(parameter);
+		}
+		return 1;
+	}
+
+	// e^(j a k^2 / 2)
+	static cplx chirp(double a, size_t k)
+	{
+		return std::polar(1.0, a * 0.5 * (double)(k * k));
+	}
+
+	ChirpZ::ChirpZ(size_t n_in, size_t n_out, double a,
+	               const std::vector<cplx>& pre_scale, const std::vector<cplx>& post_scale)
+		: n_in(n_in)
+		, n_out(n_out)
+		, fft(nextPowerOfTwo(n_in + n_out - 1))
+		, pre(n_in)
+		, post(n_out)
+		, kernel(fft.size())
+	{
+		// n m = (n^2 + m^2 - (m - n)^2) / 2, so the transform is a convolution of
+		// the chirped input with the conjugate chirp, followed by another chirp.
+		size_t L = fft.size();
+		for (size_t n = 0; n < n_in; n += 1)
+			pre[n] = pre_scale[n] * chirp(a, n);
+		for (size_t m = 0; m < n_out; m += 1)
+			post[m] = post_scale[m] * chirp(a, m) / (double)L;
+
+		for (size_t k = 0; k < n_out; k += 1)
+			kernel[k] = std::conj(chirp(a, k));
+		for (size_t k = 1; k < n_in; k += 1)
+			kernel[L - k] = std::conj(chirp(a, k));
+		fft.forward(kernel.data());
+	}
+
+	void ChirpZ::run(const cplx* in, cplx* out, std::vector<cplx>& scratch) const
+	{
+		size_t L = fft.size();
+		scratch.assign(L, cplx(0, 0));
+		for (size_t n = 0; n < n_in; n += 1)
+			scratch[n] = in[n] * pre[n];
+
+		fft.forward(scratch.data());
+		for (size_t k = 0; k < L; k += 1)
+			scratch[k] *= kernel[k];
+		fft.inverse(scratch.data());
+
+		for (size_t m = 0; m < n_out; m += 1)
+			out[m] = scratch[m] * post[m];
+	}
+
+	WorkerPool& computePool()
+	{
+		static WorkerPool pool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
+		return pool;
+	}
+
+	void parallelFor(size_t count, const std::function<void(size_t)>& fn)
+	{
+		if (count == 0)
+			return;
+
+		std::mutex lock;
+		std::condition_variable cv;
+		size_t remaining = count - 1;
+		for (size_t x = 1; x < count; x += 1)
+		{
+			computePool().submit([&, x]
+			{
+				fn(x);
+				std::lock_guard<std::mutex> guard(lock);
+				remaining -= 1;
+				if (remaining == 0)
+					cv.notify_all();
+			});
+		}
+		fn(0);
+
+		std::unique_lock<std::mutex> guard(lock);
+		cv.wait(guard, [&remaining] { return remaining == 0; });
+	}
+
+}
@@ -0,0 +1,172 @@
+// vnadll_ext_gate.cpp : Time domain gating of frequency domain traces.
+//
+
+#include <math.h>
+
+#include "vnadll_ext_dsp.h"
+
+using namespace vnaext;
+
+// Number of gate plans kept in the cache.
+static const size_t GATE_CACHE_SIZE = 16;
+
+// The time response is sampled this many times finer than the frequency spacing
+// allows, so gate edges are placed accurately.
+static const size_t GATE_OVERSAMPLE = 4;
+
+// Renormalization is skipped where the gated reference response is below this
+// fraction of its peak.
+static const double NORM_FLOOR = 1e-3;
+
+struct GateKey
+{
+	double       start_time;
+	double       stop_time;
+	int          gate_window;
+	double       gate_parameter;
+	int          window;
+	double       window_parameter;
+	bool         notch;
+	unsigned int n;
+	double       df;
+
+	bool operator==(const GateKey& other) const
+	{
+		return start_time == other.start_time && stop_time == other.stop_time
+		       && gate_window == other.gate_window && gate_parameter == other.gate_parameter
+		       && window == other.window && window_parameter == other.window_parameter
+		       && notch == other.notch && n == other.n && df == other.df;
+	}
+};
+
+struct GatePlan
+{
+	explicit GatePlan(size_t L) : fft(L) {}
+
+	FftPlan             fft;
+	std::vector<double> window;  // frequency window, N values
+	std::vector<double> gate;    // time gate, L values, already scaled by 1/L
+	std::vector<cplx>   norm;    // gated response of the window alone, N values
+};
+
+// Zero-pad `w * S`, go to the time domain, apply the gate, and come back.
+static void applyGate(const GatePlan& plan, const cplx* in, size_t N, std::vector<cplx>& work)
+{
+	size_t L = plan.fft.size();
+	work.assign(L, cplx(0, 0));
+	for (size_t n = 0; n < N; n += 1)
+		work[n] = in[n] * plan.window[n];
+
+	plan.fft.inverse(work.data());
+	for (size_t k = 0; k < L; k += 1)
+		work[k] *= plan.gate[k];
+	plan.fft.forward(work.data());
+}
+
+static std::shared_ptr<const GatePlan> buildGatePlan(const GateKey& key)
+{
+	size_t L = nextPowerOfTwo(key.n * GATE_OVERSAMPLE);
+	std::shared_ptr<GatePlan> plan(new GatePlan(L));
+
+	plan->window.resize(key.n);
+	for (unsigned int n = 0; n < key.n; n += 1)
+		plan->window[n] = windowValue(key.window, key.window_parameter, key.n > 1 ? (double)n / (key.n - 1) : 0.5);
+
+	// Sample k of the inverse FFT is at time k / (L df), circular with period
+	// 1 / df; the second half stands for negative times.
+	double df = key.df * 1e6;
+	double span = key.stop_time - key.start_time;
+	plan->gate.resize(L);
+	for (size_t k = 0; k < L; k += 1)
+	{
+		double t = (k < L / 2 ? (double)k : (double)k - (double)L) / (L * df);
+		double g = 0;
+		if (t >= key.start_time && t <= key.stop_time)
+			g = span > 0 ? windowValue(key.gate_window, key.gate_parameter, (t - key.start_time) / span) : 1;
+		if (key.notch)
+			g = 1 - g;
+		plan->gate[k] = g / L;
+	}
+
+	// Gating a truncated band smears energy past its edges. Dividing by the gated
+	// response of a reference impulse undoes that, and the window, for responses
+	// near the reference: the gate center for a pass gate, or the time furthest
+	// from the gate for a notch.
+	double t_ref = (key.start_time + key.stop_time) / 2;
+	if (key.notch)
+		t_ref += 0.5 / df;
+	std::vector<cplx> impulse(key.n);
+	for (unsigned int n = 0; n < key.n; n += 1)
+		impulse[n] = std::polar(1.0, -2 * M_PI * n * df * t_ref);
+	std::vector<cplx> work;
+	applyGate(*plan, impulse.data(), key.n, work);
+	plan->norm.resize(key.n);
+	double largest = 0;
+	for (unsigned int n = 0; n < key.n; n += 1)
+	{
+		plan->norm[n] = work[n] / impulse[n];
+		largest = fmax(largest, std::abs(plan->norm[n]));
+	}
+	// Where the window (nearly) vanishes there is nothing left to renormalize;
+	// those points come back as 0 instead of amplified noise.
+	for (unsigned int n = 0; n < key.n; n += 1)
+		if (std::abs(plan->norm[n]) < largest * NORM_FLOOR)
+			plan->norm[n] = 0;
+	return plan;
+}
+
+ErrCode timeDomainGate(const double* freqs, const unsigned int N,
+                       const ComplexData* in, const unsigned int traces,
+                       const GateConfig* config, ComplexData* out)
+{
+	if (!config || !in || !out)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (config->stop_time < config->start_time)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (!validWindow(config->gate_window) || !validWindow(config->window))
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (!freqs || N < 2)
+		return ERR_MISSING_FREQS;
+	for (unsigned int x = 0; x < traces; x += 1)
+		if (!in[x].I || !in[x].Q || !out[x].I || !out[x].Q)
+			return ERR_WRONG_PROGRAM_TYPE;
+
+	double df = (freqs[N - 1] - freqs[0]) / (N - 1);
+	if (df <= 0)
+		return ERR_MISSING_FREQS;
+	for (unsigned int n = 0; n < N; n += 1)
+		if (fabs(freqs[n] - (freqs[0] + n * df)) > df * 1e-3)
+			return ERR_MISSING_FREQS;
+
+	GateKey key;
+	key.start_time = config->start_time;
+	key.stop_time = config->stop_time;
+	key.gate_window = config->gate_window;
+	key.gate_parameter = config->gate_window == WINDOW_KAISER ? config->gate_parameter : 0;
+	key.window = config->window;
+	key.window_parameter = config->window == WINDOW_KAISER ? config->window_parameter : 0;
+	key.notch = config->notch;
+	key.n = N;
+	key.df = df;
+
+	static PlanCache<GateKey, GatePlan> cache(GATE_CACHE_SIZE);
+	std::shared_ptr<const GatePlan> plan = cache.find(key, buildGatePlan);
+
+	parallelFor(traces, [&](size_t x)
+	{
+		std::vector<cplx> input(N);
+		std::vector<cplx> work;
+		for (unsigned int n = 0; n < N; n += 1)
+			input[n] = cplx(in[x].I[n], in[x].Q[n]);
+
+		applyGate(*plan, input.data(), N, work);
+		for (unsigned int n = 0; n < N; n += 1)
+		{
+			cplx norm = plan->norm[n];
+			cplx value = norm != cplx(0, 0) ? work[n] / norm : cplx(0, 0);
+			out[x].I[n] = value.real();
+			out[x].Q[n] = value.imag();
+		}
+	});
+	return ERR_OK;
+}
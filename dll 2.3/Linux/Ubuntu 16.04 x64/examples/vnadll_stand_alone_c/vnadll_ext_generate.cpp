@@ -0,0 +1,82 @@
+// vnadll_ext_generate.cpp : Sweep generators beyond utilGenerateLinearSweep().
+//
+
+#include <algorithm>
+#include <math.h>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+static void appendLinear(std::vector<double>& freqs, double start, double stop, unsigned int N)
+{
+	for (unsigned int x = 0; x < N; x += 1)
+		freqs.push_back(N > 1 ? start + (stop - start) * x / (N - 1) : start);
+}
+
+// Snap `freqs` to legal values, sort and deduplicate them, and set the result as
+// the Task's (possibly segmented) sweep.
+static ErrCode setLegalSweep(TaskHandle t, std::vector<double>& freqs)
+{
+	if (freqs.empty())
+		return ERR_MISSING_FREQS;
+
+	ErrCode code = utilNearestLegalFreqs(t, freqs.data(), (unsigned int)freqs.size());
+	if (code != ERR_OK)
+		return code;
+
+	std::sort(freqs.begin(), freqs.end());
+	freqs.erase(std::unique(freqs.begin(), freqs.end(),
+	                        [](double a, double b) { return b - a < DUPLICATE_FREQ_TOLERANCE; }),
+	            freqs.end());
+
+	return setSegmentedFrequencies(t, freqs.data(), (unsigned int)freqs.size());
+}
+
+ErrCode utilGenerateLogSweep(TaskHandle t, const double startFreq, const double endFreq, const unsigned int N)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (N == 0)
+		return ERR_MISSING_FREQS;
+	if (startFreq <= 0 || endFreq <= 0)
+		return ERR_FREQ_OUT_OF_BOUNDS;
+
+	std::vector<double> freqs(N);
+	double ratio = log(endFreq / startFreq);
+	for (unsigned int x = 0; x < N; x += 1)
+		freqs[x] = N > 1 ? startFreq * exp(ratio * x / (N - 1)) : startFreq;
+	// Keep the end points exact; rounding in exp() could push them out of bounds.
+	freqs[N - 1] = N > 1 ? endFreq : startFreq;
+	return setLegalSweep(t, freqs);
+}
+
+ErrCode utilGenerateMultiSpanSweep(TaskHandle t, const FrequencySpan* spans, const unsigned int M)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (!spans || M == 0)
+		return ERR_MISSING_FREQS;
+
+	std::vector<double> freqs;
+	for (unsigned int x = 0; x < M; x += 1)
+		appendLinear(freqs, spans[x].start_frequency, spans[x].stop_frequency, spans[x].points);
+	return setLegalSweep(t, freqs);
+}
+
+ErrCode utilGenerateZoomSweep(TaskHandle t, const double centerFreq,
+                              const double span, const unsigned int N,
+                              const double zoomSpan, const unsigned int zoomN)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (N == 0 && zoomN == 0)
+		return ERR_MISSING_FREQS;
+	if (span < 0 || zoomSpan < 0)
+		return ERR_FREQ_OUT_OF_BOUNDS;
+
+	std::vector<double> freqs;
+	appendLinear(freqs, centerFreq - span / 2, centerFreq + span / 2, N);
+	appendLinear(freqs, centerFreq - zoomSpan / 2, centerFreq + zoomSpan / 2, zoomN);
+	return setLegalSweep(t, freqs);
+}
@@ -0,0 +1,220 @@
+// vnadll_ext_init.cpp : initialize() variants: throughput reporting, non-blocking and fleet-wide.
+//
+
+#include <chrono>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+namespace
+{
+	struct StatsContext
+	{
+		progress_stats_callback               callback;
+		void*                                 user;
+		std::chrono::steady_clock::time_point started;
+	};
+
+	bool statsProgress(int progressPercent, void* user)
+	{
+		StatsContext* ctx = static_cast<StatsContext*>(user);
+
+		InitProgress progress;
+		progress.percent = progressPercent;
+		progress.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx->started).count();
+		progress.percent_per_second = 0;
+		progress.remaining_seconds = -1;
+		if (progressPercent > 0 && progress.elapsed_seconds > 0)
+		{
+			progress.percent_per_second = progressPercent / progress.elapsed_seconds;
+			progress.remaining_seconds = (100 - progressPercent) / progress.percent_per_second;
+		}
+
+		return ctx->callback(&progress, ctx->user);
+	}
+}
+
+ErrCode initializeWithStats(TaskHandle t, progress_stats_callback callback, void* user)
+{
+	if (!callback)
+	{
+		ErrCode code = initialize(t, NULL, NULL);
+		if (code == ERR_OK)
+			refreshLattice(getExtTask(t));
+		return code;
+	}
+
+	StatsContext ctx;
+	ctx.callback = callback;
+	ctx.user = user;
+	ctx.started = std::chrono::steady_clock::now();
+	ErrCode code = initialize(t, statsProgress, &ctx);
+	if (code == ERR_OK)
+		refreshLattice(getExtTask(t));
+	return code;
+}
+
+ErrCode initializeAsync(TaskHandle t, progress_callback callback, void* user)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (getState(t) != TASK_UNINITIALIZED)
+		return ERR_WRONG_STATE;
+
+	ExtTask* et = getExtTask(t);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		if (et->in_flight || et->submitted || et->initializing)
+			return ERR_WRONG_STATE;
+
+		et->initializing = true;
+		et->init_done = false;
+		et->in_flight = true;
+	}
+
+	ioPool().submit([et, callback, user]
+	{
+		ErrCode code = initialize(et->handle, callback, user);
+		if (code == ERR_OK)
+			refreshLattice(et);
+
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->init_result = code;
+		et->init_done = true;
+		et->in_flight = false;
+		et->signalCompletion();
+		et->cv.notify_all();
+	});
+	return ERR_OK;
+}
+
+ErrCode reapInitialize(TaskHandle t)
+{
+	ExtTask* et = findExtTask(t);
+	if (!et)
+		return ERR_WRONG_STATE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (!et->initializing || !et->init_done)
+		return ERR_WRONG_STATE;
+
+	et->drainCompletion();
+	et->initializing = false;
+	et->init_done = false;
+	return et->init_result;
+}
+
+
+namespace
+{
+	// Shared between initializeMany() and the per-unit download callbacks.
+	struct FleetProgress
+	{
+		std::mutex              lock;
+		std::condition_variable cv;
+		std::vector<int>        percent;
+		std::vector<ErrCode>    result;
+		unsigned int            remaining;
+		bool                    changed;
+		bool                    keep_going;
+	};
+
+	struct UnitContext
+	{
+		FleetProgress* fleet;
+		unsigned int   index;
+	};
+
+	bool unitProgress(int progressPercent, void* user)
+	{
+		UnitContext* ctx = static_cast<UnitContext*>(user);
+		FleetProgress* fleet = ctx->fleet;
+
+		std::lock_guard<std::mutex> guard(fleet->lock);
+		if (fleet->percent[ctx->index] != progressPercent)
+		{
+			fleet->percent[ctx->index] = progressPercent;
+			fleet->changed = true;
+			fleet->cv.notify_all();
+		}
+		return fleet->keep_going;
+	}
+}
+
+ErrCode initializeMany(TaskHandle* tasks, const unsigned int N, ErrCode* results,
+                       progress_callback callback, void* user)
+{
+	if (N && !tasks)
+		return ERR_BAD_HANDLE;
+	for (unsigned int x = 0; x < N; x += 1)
+		if (!tasks[x])
+			return ERR_BAD_HANDLE;
+
+	FleetProgress fleet;
+	fleet.percent.assign(N, 0);
+	fleet.result.assign(N, ERR_OK);
+	fleet.remaining = N;
+	fleet.changed = false;
+	fleet.keep_going = true;
+
+	std::vector<UnitContext> contexts(N);
+	for (unsigned int x = 0; x < N; x += 1)
+	{
+		contexts[x].fleet = &fleet;
+		contexts[x].index = x;
+
+		UnitContext* ctx = &contexts[x];
+		TaskHandle t = tasks[x];
+		ioPool().submit([ctx, t]
+		{
+			ErrCode code = initialize(t, unitProgress, ctx);
+			if (code == ERR_OK)
+				refreshLattice(getExtTask(t));
+
+			FleetProgress* fleet = ctx->fleet;
+			std::lock_guard<std::mutex> guard(fleet->lock);
+			fleet->result[ctx->index] = code;
+			fleet->percent[ctx->index] = 100;
+			fleet->remaining -= 1;
+			fleet->changed = true;
+			fleet->cv.notify_all();
+		});
+	}
+
+	int last_reported = -1;
+	std::unique_lock<std::mutex> guard(fleet.lock);
+	while (true)
+	{
+		fleet.cv.wait(guard, [&fleet] { return fleet.changed || fleet.remaining == 0; });
+		fleet.changed = false;
+
+		int sum = 0;
+		for (unsigned int x = 0; x < N; x += 1)
+			sum += fleet.percent[x];
+		int aggregate = N ? sum / (int)N : 100;
+
+		if (callback && aggregate != last_reported && fleet.keep_going)
+		{
+			last_reported = aggregate;
+			guard.unlock();
+			bool keep_going = callback(aggregate, user);
+			guard.lock();
+			if (!keep_going)
+				fleet.keep_going = false;
+		}
+
+		if (fleet.remaining == 0)
+			break;
+	}
+
+	ErrCode ret = ERR_OK;
+	for (unsigned int x = 0; x < N; x += 1)
+	{
+		if (results)
+			results[x] = fleet.result[x];
+		if (ret == ERR_OK && fleet.result[x] != ERR_OK)
+			ret = fleet.result[x];
+	}
+	return ret;
+}
@@ -0,0 +1,380 @@
+// vnadll_ext_internal.h : Shared state for the host-side VNA extensions.
+// Not part of the public API; only included by the vnadll_ext_*.cpp files.
+
+#ifndef __AKELA_VNA_EXT_INTERNAL_HEADER
+#define __AKELA_VNA_EXT_INTERNAL_HEADER
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "vnadll_ext.h"
+
+namespace vnaext
+{
+
+	// Number of ComplexData outputs of the widest measurement function (measureUncalibrated()).
+	const int NUM_OUTPUTS = 5;
+
+	// Frequencies closer than this, in MHz, are considered the same point.
+	const double DUPLICATE_FREQ_TOLERANCE = 1e-9;
+
+	// Pool of worker threads. With `max_threads` == 0 the pool grows on demand, so
+	// every queued job gets a thread immediately; this is what the blocking DLL calls
+	// need, since a job can sit in a socket receive for the whole sweep. Idle threads
+	// are reused for later jobs.
+	class WorkerPool
+	{
+	public:
+		explicit WorkerPool(size_t max_threads);
+		~WorkerPool();
+
+		void submit(std::function<void()> job);
+
+	private:
+		void run();
+
+		std::mutex                         lock;
+		std::condition_variable            cv;
+		std::deque<std::function<void()> > jobs;
+		std::vector<std::thread>           threads;
+		size_t                             idle;
+		size_t                             max_threads;
+		bool                               stopping;
+	};
+
+	// Pool used for jobs that block inside the DLL.
+	WorkerPool& ioPool();
+
+	// One hardware-sized piece of a segmented sweep.
+	struct Segment
+	{
+		std::vector<double> freqs;   // as generated by the hardware (see getFrequencies())
+		size_t              offset;  // index of the first point in the stitched output
+		HopRate             hop;     // HOP_UNDEFINED to keep the Task setting
+		Attenuation         atten;   // ATTEN_UNDEFINED to keep the Task setting
+	};
+
+	// Frequency plan of a sweep that may need more than one program.
+	struct SweepPlan
+	{
+		SweepPlan() : active(false), loaded(-1) {}
+
+		bool                 active;
+		std::vector<Segment> segments;
+		std::vector<double>  freqs;    // stitched frequency list, in output order
+		int                  loaded;   // segment programmed last, -1 if unknown
+		std::vector<double>  scratch;  // getFrequencies() buffer used to verify `loaded`
+
+		// If the points were reordered, `index[n]` is the output position of the
+		// n-th programmed point. Empty if programmed order == output order.
+		std::vector<unsigned int> index;
+		std::vector<double>       unpermute;  // staging buffer for un-permuting the output
+	};
+
+	// Legal frequencies of one synthesizer band: offset + k * step, for lo <= f < hi.
+	struct BandLattice
+	{
+		BandLattice() : lo(0), hi(0), step(0), offset(0), regular(false) {}
+
+		double lo;
+		double hi;
+		double step;
+		double offset;   // a lattice point inside the band
+		bool   regular;  // false if the band could not be modelled; use the DLL instead
+	};
+
+	// Frequency lattice of one unit, indexed by bandOf().
+	struct FrequencyLattice
+	{
+		FrequencyLattice() : serial(0), valid(false) {}
+
+		int                      serial;  // serial number of the unit the lattice was probed on
+		bool                     valid;
+		std::vector<BandLattice> bands;
+	};
+
+	// Continuous-wave sample stream, see startCWStream().
+	struct CWStream
+	{
+		CWStream() : running(false), stopping(false), head(0), count(0), dropped(0), blocks(0), error(ERR_OK), rate(0) {}
+
+		bool                     running;   // the streaming loop owns `in_flight`
+		bool                     stopping;
+		std::vector<CWSample>    ring;
+		size_t                   head;      // index of the oldest sample in `ring`
+		size_t                   count;
+		unsigned int             dropped;   // samples overwritten since the last readCWStream()
+		unsigned int             blocks;
+		ErrCode                  error;     // the error that stopped the stream, until reported by stopCWStream()
+		double                   rate;      // samples per second
+		std::chrono::steady_clock::time_point origin;
+	};
+
+	// One result of the measurement scheduler, see startScheduledMeasurements().
+	struct ScheduledRecord
+	{
+		ScheduledResult     info;
+		std::vector<double> i[NUM_OUTPUTS];
+		std::vector<double> q[NUM_OUTPUTS];
+	};
+
+	// Fixed-cadence measurement scheduler state.
+	struct Schedule
+	{
+		Schedule() : running(false), stopping(false), kind(0), head(0), count(0), dropped(0) {}
+
+		bool                         running;  // the scheduler loop owns `in_flight`
+		bool                         stopping;
+		MeasurementKind              kind;
+		std::vector<ScheduledRecord> queue;    // results not yet reaped, oldest at `head`
+		size_t                       head;
+		size_t                       count;
+		unsigned int                 dropped;  // results overwritten since the last reap
+	};
+
+	// Sweep averaging settings and state, see setAveraging().
+	struct Averaging
+	{
+		Averaging() : mode(0), count(1), restart(false), sweeps(0), kind(0), points(0), mask(0) {}
+
+		AverageMode         mode;
+		unsigned int        count;
+		bool                restart;   // discard the running average before the next sweep
+
+		// Running state, only touched by the thread that owns `in_flight`
+		unsigned int        sweeps;    // sweeps in the exponential average, up to `count`
+		MeasurementKind     kind;
+		size_t              points;
+		unsigned int        mask;      // arrays being averaged: bit 2x for I of output x, 2x + 1 for Q
+		std::vector<double> i[NUM_OUTPUTS];  // exponential average, or block scratch
+		std::vector<double> q[NUM_OUTPUTS];
+	};
+
+	// Background subtracted from uncalibrated sweeps, see setBaseline().
+	// applyBaseline() swaps the arrays out while it subtracts and back after,
+	// unless `generation` has moved on.
+	struct Baseline
+	{
+		Baseline() : active(false), alpha(0), points(0), valid(), generation(0) {}
+
+		bool                active;
+		double              alpha;     // 0 for a fixed background
+		size_t              points;
+		bool                valid[NUM_OUTPUTS];
+		std::vector<double> i[NUM_OUTPUTS];
+		std::vector<double> q[NUM_OUTPUTS];
+		unsigned int        generation; // bumped by setBaseline() and clearBaseline()
+	};
+
+	// Inverse fixture networks set by setDeembedding(), see vnadll_ext_deembed.cpp.
+	struct DeembedPlan;
+
+	// Per-point statistics accumulator, see vnadll_ext_stats.cpp.
+	struct Statistics;
+
+	// Post-processing pipeline attached to a Task, see vnadll_ext_pipeline.cpp.
+	struct PipelineRun;
+
+	// Slow-time Doppler accumulator, see vnadll_ext_doppler.cpp.
+	struct DopplerState;
+
+	// Per-Task extension state. Created on first use by getExtTask() and
+	// destroyed by deleteTaskExtensions().
+	struct ExtTask
+	{
+		explicit ExtTask(TaskHandle t);
+		~ExtTask();
+
+		// Make the completion descriptor readable / consume its pending events.
+		void signalCompletion();
+		void drainCompletion();
+
+		TaskHandle              handle;
+		int                     completion_fd;
+
+		// Everything below is guarded by `lock`; `cv` is notified whenever
+		// `in_flight` drops to false.
+		std::mutex              lock;
+		std::condition_variable cv;
+
+		// Non-blocking measurement state
+		bool                    submitted;   // submitMeasurement() called, not yet reaped
+		bool                    in_flight;   // a worker is inside a DLL measurement call
+		bool                    done;        // result is ready to be reaped
+		bool                    abandoned;   // the call in flight was cancelled; discard its result
+		bool                    queued;      // a submission is waiting for the abandoned call to return
+		bool                    abort;       // cancelMeasurement() was called; stop before the next DLL measurement call
+		MeasurementKind         kind;
+		ErrCode                 result;
+		unsigned int            points;
+		std::vector<double>     buf_i[NUM_OUTPUTS];
+		std::vector<double>     buf_q[NUM_OUTPUTS];
+
+		// Segmented sweep. Only touched by the thread that owns `in_flight`,
+		// or under `lock` while nothing is in flight.
+		SweepPlan               plan;
+		FrequencyOrder          ordering;
+
+		// Continuous-wave streaming state
+		CWStream                cw;
+
+		// Measurement scheduler state
+		Schedule                schedule;
+
+		// Frequency lattice of the connected unit, see refreshLattice()
+		FrequencyLattice        lattice;
+
+		// Sweep averaging; settings guarded by `lock`
+		Averaging               averaging;
+
+		// Ratio mode, see setRatioMode(). The flag is guarded by `lock`, the
+		// buffers belong to the thread that owns `in_flight`.
+		bool                    ratio_mode;
+		std::vector<double>     ratio_i[NUM_OUTPUTS];  // halves of the sweep the caller did not ask for
+		std::vector<double>     ratio_q[NUM_OUTPUTS];
+		std::vector<double>     ratio_rec_i;           // 1 / Ref
+		std::vector<double>     ratio_rec_q;
+
+		// Background subtraction for uncalibrated sweeps, guarded by `lock`
+		Baseline                baseline;
+
+		// Fixture de-embedding applied to calibrated measurements; replaced as a
+		// whole, so a measurement in flight keeps the plan it started with
+		std::shared_ptr<const DeembedPlan> deembed;
+
+		// Accumulator fed by every measurement, see attachStatistics()
+		std::shared_ptr<Statistics> statistics;
+
+		// Post-processing pipeline, see attachPipeline(). Only replaced under
+		// `lock` while nothing is in flight.
+		std::shared_ptr<PipelineRun> pipeline;
+
+		// Doppler processing started by startDoppler(); replaced under `lock`
+		std::shared_ptr<DopplerState> doppler;
+
+		// Lazy factory calibration state
+		bool                    lazy_factory_cal;
+		bool                    factory_cal_loaded; // the current calibration came from ensureCalibration()
+		size_t                  cal_points;         // number of points of that calibration
+		double                  cal_span_lo;        // frequencies of its first and last point, MHz
+		double                  cal_span_hi;
+
+		// Non-blocking initialize() state
+		bool                    initializing; // initializeAsync() called, not yet reaped
+		bool                    init_done;
+		ErrCode                 init_result;
+	};
+
+	// Look up the extension state for `t`, creating it if required.
+	// Returns NULL only if `t` is NULL.
+	ExtTask* getExtTask(TaskHandle t);
+
+	// Look up the extension state for `t` without creating it.
+	ExtTask* findExtTask(TaskHandle t);
+
+	// Point `out[n]` at the measurement buffers of `et`, sized for `et->points`.
+	void bindBuffers(ExtTask* et, ComplexData out[NUM_OUTPUTS]);
+
+	// Copy `n` points from the buffers of `et` into caller-owned arrays.
+	// Null destination pointers are skipped.
+	void copyBuffers(ExtTask* et, const ComplexData out[NUM_OUTPUTS], unsigned int n);
+
+	// Run one blocking measurement of type `kind` into `out`, covering the whole
+	// segmented sweep if one is configured, with averaging, ratio, background
+	// subtraction, de-embedding and the pipeline applied and the result added to the attached
+	// statistics and Doppler processing.
+	// The caller must own `et->in_flight`.
+	ErrCode measureInto(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS]);
+
+	// The stages of measureInto() without a pipeline. measureRaw() measures the
+	// sweep with the calibration, averaging and ratio mode applied,
+	// applyCorrections() subtracts the background or de-embeds the fixtures in
+	// place, and feedAccumulators() adds the result to the statistics and Doppler
+	// processing. The caller must own `et->in_flight` and not hold `et->lock`.
+	ErrCode measureRaw(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS]);
+	ErrCode applyCorrections(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS]);
+	void feedAccumulators(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS]);
+
+	// Measure the configured sweep once into `out`, with no averaging or
+	// post-processing. The caller must own `et->in_flight`.
+	ErrCode measureSweep(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS]);
+
+	// Measure into `out` with the averaging configured on `et` applied.
+	// The caller must own `et->in_flight`.
+	ErrCode measureAveraged(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS]);
+
+	// Compile `freqs` into the segmented sweep plan of `et`, applying `et->ordering`.
+	// The Task must be stopped; the caller must hold `et->lock` or own `et->in_flight`.
+	ErrCode loadPlan(ExtTask* et, const double* freqs, unsigned int N);
+
+	// Number of points in the sweep measureInto() measures.
+	unsigned int sweepPoints(ExtTask* et);
+
+	// Number of points per output returned by measureInto(), after any pipeline.
+	unsigned int resultPoints(ExtTask* et);
+
+	// Lowest and highest frequency of the sweep measureInto() covers.
+	bool sweepSpan(ExtTask* et, double* lo, double* hi);
+
+	// Index of the synthesizer band containing `freq`, counted from the highest band.
+	int bandOf(const HardwareDetails& details, double freq);
+
+	// Programmed order for `freqs` under `ordering`: order[n] is the index in `freqs`
+	// of the n-th point to program. Returns an empty vector for ORDER_AS_GIVEN.
+	std::vector<unsigned int> pointOrder(TaskHandle t, FrequencyOrder ordering,
+	                                     const double* freqs, unsigned int N);
+
+	// Probe the frequency lattice of the unit `et` is connected to, unless it is
+	// already known. Must be called without `et->lock` held.
+	ErrCode refreshLattice(ExtTask* et);
+
+	// De-embed the calibrated S-parameters in `out` in place, if a fixture is set
+	// on `et`. Must be called without `et->lock` held.
+	ErrCode applyDeembedding(ExtTask* et, const ComplexData out[NUM_OUTPUTS]);
+
+	// If ratio mode is on, set `in` to `out` completed with the buffers the ratio
+	// needs (Ref, and the missing half of any requested path) and return true.
+	// The caller must own `et->in_flight`.
+	bool ratioInput(ExtTask* et, const ComplexData out[NUM_OUTPUTS], ComplexData in[NUM_OUTPUTS]);
+
+	// Divide paths 0 to 3 of `in` (see ratioInput()) by Ref, in place.
+	void applyRatio(ExtTask* et, const ComplexData in[NUM_OUTPUTS]);
+
+	// Subtract the background set on `et` from the uncalibrated sweep in `out`,
+	// updating it if it adapts. Must be called without `et->lock` held.
+	ErrCode applyBaseline(ExtTask* et, const ComplexData out[NUM_OUTPUTS]);
+
+	// If a pipeline is attached to `et`, point `raw` at its input buffers and
+	// return true. The caller must own `et->in_flight`.
+	bool pipelineInput(ExtTask* et, MeasurementKind kind, ComplexData raw[NUM_OUTPUTS]);
+
+	// Run the attached pipeline from `raw` (see pipelineInput()) into `out`.
+	// The caller must own `et->in_flight`.
+	void runPipeline(ExtTask* et, MeasurementKind kind, const ComplexData raw[NUM_OUTPUTS],
+	                 const ComplexData out[NUM_OUTPUTS]);
+
+	// Add the measurement in `out` to the statistics attached to `et`, if any.
+	// Must be called without `et->lock` held.
+	void feedStatistics(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS]);
+
+	// Add the measurement in `out` to the Doppler block of `et`, if started, and
+	// hand full blocks to the compute pool. The caller must own `et->in_flight`
+	// and not hold `et->lock`.
+	void feedDoppler(ExtTask* et, const ComplexData out[NUM_OUTPUTS]);
+
+	// Points per second of `hop`, or 0 if `hop` is not a known hop rate.
+	double hopPointsPerSecond(HopRate hop);
+
+	// Load (or reload) the factory calibration for the current sweep if lazy
+	// loading is enabled on `et`. Must be called without `et->lock` held.
+	ErrCode ensureCalibration(ExtTask* et);
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+// vnadll_ext_lattice.cpp : Host-side model of the synthesizer frequency lattice,
+// and batch frequency snapping built on it.
+//
+
+#include <math.h>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+// Number of frequencies per band compared against utilNearestLegalFreq() before
+// a band's lattice is trusted.
+static const int LATTICE_PROBES = 32;
+
+static double nearestLegal(TaskHandle t, double freq)
+{
+	utilNearestLegalFreq(t, &freq);
+	return freq;
+}
+
+static double snapToLattice(const BandLattice& band, double freq)
+{
+	return band.offset + nearbyint((freq - band.offset) / band.step) * band.step;
+}
+
+// Infer step and offset of the lattice between `band.lo` and `band.hi` from the
+// DLL, and check the result against it. Leaves `band.regular` false if the band
+// does not look like a single evenly spaced lattice.
+static void probeBand(TaskHandle t, BandLattice& band)
+{
+	band.regular = false;
+	double width = band.hi - band.lo;
+	if (width <= 0)
+		return;
+
+	// Grow `delta` until the point after `a` becomes the nearest one. Since
+	// `delta` at most doubles past step / 2, `b` is always the next lattice point.
+	double a = nearestLegal(t, band.lo + width / 2);
+	double delta = 1e-6;
+	double b = a;
+	while (b == a && delta < width / 4)
+	{
+		delta *= 2;
+		b = nearestLegal(t, a + delta);
+	}
+	if (b <= a)
+		return;
+
+	band.step = b - a;
+	if (band.step * 4 > width)
+		return;
+
+	// Refine the step over a long baseline, so rounding in the DLL's values does
+	// not accumulate across the band. Anchoring on a lattice point returned by the
+	// DLL (rather than reducing it modulo the step) keeps the snapped values
+	// identical to the DLL's near `a`.
+	double span = nearbyint(width / 4 / band.step);
+	double c = nearestLegal(t, a - span * band.step);
+	span = nearbyint((a - c) / band.step);
+	if (span >= 1)
+		band.step = (a - c) / span;
+	band.offset = a;
+
+	for (int x = 0; x < LATTICE_PROBES; x += 1)
+	{
+		double freq = band.lo + band.step + (width - 2 * band.step) * (x + 0.37) / LATTICE_PROBES;
+		if (fabs(nearestLegal(t, freq) - snapToLattice(band, freq)) > band.step * 1e-6)
+			return;
+	}
+	band.regular = true;
+}
+
+static void buildLattice(TaskHandle t, const HardwareDetails& details, FrequencyLattice& lattice)
+{
+	int nb = details.number_of_band_boundaries < 8 ? details.number_of_band_boundaries : 8;
+
+	lattice.serial = details.serial_number;
+	lattice.bands.assign(nb + 1, BandLattice());
+	for (int k = 0; k <= nb; k += 1)
+	{
+		// Band k holds the frequencies below exactly k of the (descending) boundaries.
+		BandLattice& band = lattice.bands[k];
+		band.lo = k < nb ? details.band_boundaries[k] : details.minimum_frequency;
+		band.hi = k > 0 ? details.band_boundaries[k - 1] : details.maximum_frequency;
+		band.lo = fmax(band.lo, details.minimum_frequency);
+		band.hi = fmin(band.hi, details.maximum_frequency);
+		probeBand(t, band);
+	}
+	lattice.valid = true;
+}
+
+ErrCode vnaext::refreshLattice(ExtTask* et)
+{
+	if (getState(et->handle) == TASK_UNINITIALIZED)
+		return ERR_WRONG_STATE;
+
+	HardwareDetails details = getHardwareDetails(et->handle);
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (!et->lattice.valid || et->lattice.serial != details.serial_number)
+		buildLattice(et->handle, details, et->lattice);
+	return ERR_OK;
+}
+
+ErrCode utilNearestLegalFreqs(TaskHandle t, double* freqs, const unsigned int N)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (!freqs)
+		return ERR_MISSING_FREQS;
+
+	ExtTask* et = getExtTask(t);
+	ErrCode code = refreshLattice(et);
+	if (code != ERR_OK)
+		return code;
+
+	HardwareDetails details = getHardwareDetails(t);
+	std::vector<BandLattice> bands;
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		bands = et->lattice.bands;
+	}
+
+	ErrCode ret = ERR_OK;
+	for (unsigned int x = 0; x < N; x += 1)
+	{
+		double freq = freqs[x];
+		if (freq >= details.minimum_frequency && freq <= details.maximum_frequency)
+		{
+			// Points within a step of a band edge may snap across the boundary;
+			// leave those, and irregular bands, to the DLL.
+			const BandLattice& band = bands[bandOf(details, freq)];
+			if (band.regular && freq - band.lo >= band.step && band.hi - freq >= band.step)
+			{
+				freqs[x] = snapToLattice(band, freq);
+				continue;
+			}
+		}
+
+		code = utilNearestLegalFreq(t, &freqs[x]);
+		if (ret == ERR_OK)
+			ret = code;
+	}
+	return ret;
+}
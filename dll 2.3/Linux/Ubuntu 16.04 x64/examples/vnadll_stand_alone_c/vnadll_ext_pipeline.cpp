@@ -0,0 +1,440 @@
+// vnadll_ext_pipeline.cpp : Per-Task chains of post-processing stages.
+//
+
+#include <algorithm>
+#include <math.h>
+
+#include "vnadll_ext_dsp.h"
+
+using namespace vnaext;
+
+// Points processed by one pass of a run of element-wise stages, so a chunk
+// stays in L1 while every stage of the run is applied to it.
+static const size_t CHUNK_POINTS = 512;
+
+// Below this many points per measurement, the outputs are processed on the
+// calling thread; handing them to the compute pool would cost more.
+static const size_t PARALLEL_POINTS = 32768;
+
+namespace vnaext
+{
+
+	enum StageType
+	{
+		STAGE_RATIO,
+		STAGE_AVERAGE,
+		STAGE_WINDOW,
+		STAGE_INVERSE_FFT,
+		STAGE_MAGNITUDE,
+		STAGE_DECIMATE
+	};
+
+	struct PipelineStage
+	{
+		StageType    type;
+		WindowType   window;
+		double       parameter;  // window parameter
+		unsigned int count;      // sweeps to average, FFT size, or decimation factor
+		bool         db;
+	};
+
+	// Stage data that depends on the number of points reaching the stage.
+	struct PreparedStage
+	{
+		size_t                   points_in;
+		size_t                   points_out;
+		std::vector<double>      window;
+		std::shared_ptr<FftPlan> fft;
+	};
+
+	// Working state of one output.
+	struct PipelineChannel
+	{
+		std::vector<cplx>              work;
+		std::vector<std::vector<cplx> > average;  // per stage, empty for other stage types
+		std::vector<unsigned int>      sweeps;   // per stage, sweeps in the average
+	};
+
+	// A pipeline attached to a Task. Only touched by the thread that owns `in_flight`.
+	struct PipelineRun
+	{
+		PipelineRun() : points(0) {}
+
+		std::vector<PipelineStage> stages;
+		size_t                     points;  // sweep points the buffers are sized for, 0 if not yet
+		std::vector<PreparedStage> prepared;
+		PipelineChannel            channels[NUM_OUTPUTS];
+		std::vector<double>        raw_i[NUM_OUTPUTS];  // measurement before the pipeline
+		std::vector<double>        raw_q[NUM_OUTPUTS];
+		std::vector<double>        rec_i;               // 1 / Ref, for ratio stages
+		std::vector<double>        rec_q;
+	};
+
+}
+
+struct pipeline_t
+{
+	std::vector<PipelineStage> stages;
+};
+
+static bool elementWise(StageType type)
+{
+	return type != STAGE_INVERSE_FFT && type != STAGE_DECIMATE;
+}
+
+static size_t stageOutputPoints(const PipelineStage& stage, size_t points)
+{
+	if (stage.type == STAGE_INVERSE_FFT)
+		return std::max<size_t>(stage.count, nextPowerOfTwo(points));
+	if (stage.type == STAGE_DECIMATE)
+		return points / stage.count;
+	return points;
+}
+
+static size_t outputPoints(const std::vector<PipelineStage>& stages, size_t points)
+{
+	for (size_t s = 0; s < stages.size(); s += 1)
+		points = stageOutputPoints(stages[s], points);
+	return points;
+}
+
+// Size every buffer and table for `points` input points. Nothing is allocated
+// while the number of points stays the same.
+static void prepare(PipelineRun& run, size_t points)
+{
+	if (run.points == points)
+		return;
+
+	size_t count = run.stages.size();
+	run.prepared.assign(count, PreparedStage());
+	size_t largest = points;
+	size_t n = points;
+	for (size_t s = 0; s < count; s += 1)
+	{
+		const PipelineStage& stage = run.stages[s];
+		PreparedStage& prep = run.prepared[s];
+		prep.points_in = n;
+		prep.points_out = stageOutputPoints(stage, n);
+
+		if (stage.type == STAGE_WINDOW)
+		{
+			prep.window.resize(n);
+			for (size_t x = 0; x < n; x += 1)
+				prep.window[x] = windowValue(stage.window, stage.parameter, n > 1 ? (double)x / (n - 1) : 0.5);
+		}
+		else if (stage.type == STAGE_INVERSE_FFT)
+			prep.fft.reset(new FftPlan(prep.points_out));
+
+		n = prep.points_out;
+		largest = std::max(largest, n);
+	}
+
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		PipelineChannel& ch = run.channels[x];
+		ch.work.resize(largest);
+		ch.average.assign(count, std::vector<cplx>());
+		ch.sweeps.assign(count, 0);
+		for (size_t s = 0; s < count; s += 1)
+			if (run.stages[s].type == STAGE_AVERAGE)
+				ch.average[s].resize(run.prepared[s].points_in);
+
+		run.raw_i[x].resize(points);
+		run.raw_q[x].resize(points);
+	}
+	run.rec_i.resize(points);
+	run.rec_q.resize(points);
+	run.points = points;
+}
+
+// Apply element-wise stage `s` to points [first, first + n) of `work`.
+// `ratio` is false for outputs ratio stages leave alone.
+static void applyElementWise(PipelineRun& run, PipelineChannel& ch, size_t s, cplx* work,
+                             size_t first, size_t n, bool ratio)
+{
+	const PipelineStage& stage = run.stages[s];
+	switch (stage.type)
+	{
+	case STAGE_RATIO:
+	{
+		if (!ratio)
+			break;
+		const double* rec_i = run.rec_i.data() + first;
+		const double* rec_q = run.rec_q.data() + first;
+		for (size_t x = 0; x < n; x += 1)
+			work[x] *= cplx(rec_i[x], rec_q[x]);
+		break;
+	}
+
+	case STAGE_AVERAGE:
+	{
+		double weight = 1.0 / ch.sweeps[s];
+		cplx* avg = ch.average[s].data() + first;
+		for (size_t x = 0; x < n; x += 1)
+		{
+			avg[x] += (work[x] - avg[x]) * weight;
+			work[x] = avg[x];
+		}
+		break;
+	}
+
+	case STAGE_WINDOW:
+	{
+		const double* window = run.prepared[s].window.data() + first;
+		for (size_t x = 0; x < n; x += 1)
+			work[x] *= window[x];
+		break;
+	}
+
+	case STAGE_MAGNITUDE:
+		for (size_t x = 0; x < n; x += 1)
+		{
+			double mag = std::abs(work[x]);
+			work[x] = cplx(stage.db ? 20 * log10(mag) : mag, 0);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+// Run every stage over output `x` of `in` and store the result in `out`.
+// `ratio` is false if ratio stages pass the output through.
+static void runChannel(PipelineRun& run, int x, const ComplexData& in, bool ratio,
+                       const ComplexData& out)
+{
+	PipelineChannel& ch = run.channels[x];
+	cplx* work = ch.work.data();
+	size_t n = run.points;
+	for (size_t p = 0; p < n; p += 1)
+		work[p] = cplx(in.I[p], in.Q[p]);
+
+	size_t count = run.stages.size();
+	size_t s = 0;
+	while (s < count)
+	{
+		const PipelineStage& stage = run.stages[s];
+		if (elementWise(stage.type))
+		{
+			size_t end = s;
+			while (end < count && elementWise(run.stages[end].type))
+			{
+				if (run.stages[end].type == STAGE_AVERAGE)
+					ch.sweeps[end] = std::min(ch.sweeps[end] + 1, run.stages[end].count);
+				end += 1;
+			}
+
+			for (size_t first = 0; first < n; first += CHUNK_POINTS)
+			{
+				size_t chunk = std::min(CHUNK_POINTS, n - first);
+				for (size_t y = s; y < end; y += 1)
+					applyElementWise(run, ch, y, work + first, first, chunk, ratio);
+			}
+			s = end;
+			continue;
+		}
+
+		const PreparedStage& prep = run.prepared[s];
+		if (stage.type == STAGE_INVERSE_FFT)
+		{
+			// Zero-pad, transform, and scale so a flat spectrum gives a unit impulse.
+			std::fill(work + n, work + prep.points_out, cplx(0, 0));
+			prep.fft->inverse(work);
+			double scale = n > 0 ? 1.0 / n : 0;
+			for (size_t p = 0; p < prep.points_out; p += 1)
+				work[p] *= scale;
+		}
+		else if (stage.type == STAGE_DECIMATE)
+		{
+			// Boxcar average of each group of `count` points.
+			unsigned int factor = stage.count;
+			for (size_t p = 0; p < prep.points_out; p += 1)
+			{
+				cplx sum(0, 0);
+				for (unsigned int y = 0; y < factor; y += 1)
+					sum += work[p * factor + y];
+				work[p] = sum / (double)factor;
+			}
+		}
+		n = prep.points_out;
+		s += 1;
+	}
+
+	for (size_t p = 0; p < n; p += 1)
+	{
+		if (out.I)
+			out.I[p] = work[p].real();
+		if (out.Q)
+			out.Q[p] = work[p].imag();
+	}
+}
+
+namespace vnaext
+{
+
+	unsigned int resultPoints(ExtTask* et)
+	{
+		unsigned int points = sweepPoints(et);
+		if (!et->pipeline)
+			return points;
+		return (unsigned int)outputPoints(et->pipeline->stages, points);
+	}
+
+	bool pipelineInput(ExtTask* et, MeasurementKind kind, ComplexData raw[NUM_OUTPUTS])
+	{
+		PipelineRun* run = et->pipeline.get();
+		if (!run)
+			return false;
+
+		prepare(*run, sweepPoints(et));
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			raw[x].I = run->raw_i[x].data();
+			raw[x].Q = run->raw_q[x].data();
+		}
+		if (kind == MEAS_2PORT_CALIBRATED)
+			raw[4].I = raw[4].Q = NULL;
+		return true;
+	}
+
+	void runPipeline(ExtTask* et, MeasurementKind kind, const ComplexData raw[NUM_OUTPUTS],
+	                 const ComplexData out[NUM_OUTPUTS])
+	{
+		PipelineRun& run = *et->pipeline;
+
+		// Ratios are taken against the Ref path of uncalibrated measurements;
+		// calibrated S-parameters are ratios already. The reciprocal of Ref is
+		// computed once and shared by every output.
+		bool ratio = kind == MEAS_UNCALIBRATED;
+		if (ratio)
+		{
+			for (size_t s = 0; s < run.stages.size(); s += 1)
+			{
+				if (run.stages[s].type == STAGE_RATIO)
+				{
+					referenceReciprocal(raw[4].I, raw[4].Q, run.rec_i.data(), run.rec_q.data(), run.points);
+					break;
+				}
+			}
+		}
+
+		int channels[NUM_OUTPUTS];
+		int count = 0;
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+			if (raw[x].I && (out[x].I || out[x].Q))
+				channels[count++] = x;
+
+		auto job = [&](size_t y)
+		{
+			int x = channels[y];
+			runChannel(run, x, raw[x], ratio && x != 4, out[x]);
+		};
+		if (run.points * count >= PARALLEL_POINTS)
+			parallelFor(count, job);
+		else
+			for (int y = 0; y < count; y += 1)
+				job(y);
+	}
+
+}
+
+PipelineHandle createPipeline()
+{
+	return new pipeline_container;
+}
+
+void deletePipeline(PipelineHandle p)
+{
+	delete p;
+}
+
+static ErrCode addStage(PipelineHandle p, StageType type, WindowType window, double parameter,
+                        unsigned int count, bool db)
+{
+	if (!p)
+		return ERR_BAD_HANDLE;
+
+	PipelineStage stage;
+	stage.type = type;
+	stage.window = window;
+	stage.parameter = parameter;
+	stage.count = count;
+	stage.db = db;
+	p->stages.push_back(stage);
+	return ERR_OK;
+}
+
+ErrCode addRatioStage(PipelineHandle p)
+{
+	if (!p)
+		return ERR_BAD_HANDLE;
+
+	// The ratio is taken point by point against the measured Ref path, so it
+	// has to come before anything that changes the number of points.
+	for (size_t s = 0; s < p->stages.size(); s += 1)
+		if (!elementWise(p->stages[s].type))
+			return ERR_WRONG_PROGRAM_TYPE;
+	return addStage(p, STAGE_RATIO, WINDOW_RECT, 0, 0, false);
+}
+
+ErrCode addAverageStage(PipelineHandle p, const unsigned int N)
+{
+	if (N == 0)
+		return ERR_WRONG_PROGRAM_TYPE;
+	return addStage(p, STAGE_AVERAGE, WINDOW_RECT, 0, N, false);
+}
+
+ErrCode addWindowStage(PipelineHandle p, const WindowType window, const double parameter)
+{
+	if (!validWindow(window))
+		return ERR_WRONG_PROGRAM_TYPE;
+	return addStage(p, STAGE_WINDOW, window, parameter, 0, false);
+}
+
+ErrCode addInverseFftStage(PipelineHandle p, const unsigned int points)
+{
+	if (points != 0 && nextPowerOfTwo(points) != points)
+		return ERR_WRONG_PROGRAM_TYPE;
+	return addStage(p, STAGE_INVERSE_FFT, WINDOW_RECT, 0, points, false);
+}
+
+ErrCode addMagnitudeStage(PipelineHandle p, const bool db)
+{
+	return addStage(p, STAGE_MAGNITUDE, WINDOW_RECT, 0, 0, db);
+}
+
+ErrCode addDecimationStage(PipelineHandle p, const unsigned int factor)
+{
+	if (factor == 0)
+		return ERR_WRONG_PROGRAM_TYPE;
+	return addStage(p, STAGE_DECIMATE, WINDOW_RECT, 0, factor, false);
+}
+
+unsigned int getPipelineOutputPoints(PipelineHandle p, const unsigned int N)
+{
+	if (!p)
+		return N;
+	return (unsigned int)outputPoints(p->stages, N);
+}
+
+ErrCode attachPipeline(TaskHandle t, PipelineHandle p)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (et->in_flight || et->submitted)
+		return ERR_WRONG_STATE;
+
+	if (p && !p->stages.empty())
+	{
+		std::shared_ptr<PipelineRun> run(new PipelineRun);
+		run->stages = p->stages;
+		et->pipeline = run;
+	}
+	else
+		et->pipeline.reset();
+	return ERR_OK;
+}
@@ -0,0 +1,97 @@
+// vnadll_ext_ratio.cpp : Normalization of the measured paths by the Ref path.
+//
+
+#include <algorithm>
+
+#include "vnadll_ext_dsp.h"
+
+using namespace vnaext;
+
+// Reference power below which the reciprocal is taken as 0, so a dead Ref
+// point gives 0 instead of inf / nan.
+static const double MIN_REFERENCE_POWER = 1e-30;
+
+namespace vnaext
+{
+
+	void referenceReciprocal(const double* ref_i, const double* ref_q, double* rec_i, double* rec_q, size_t n)
+	{
+		for (size_t x = 0; x < n; x += 1)
+		{
+			double power = ref_i[x] * ref_i[x] + ref_q[x] * ref_q[x];
+			// Written without a branch so the loop vectorizes: a dead point
+			// divides 0 by power + 1.
+			double keep = (double)(power > MIN_REFERENCE_POWER);
+			double scale = keep / (power + (1.0 - keep));
+			rec_i[x] = ref_i[x] * scale;
+			rec_q[x] = -ref_q[x] * scale;
+		}
+	}
+
+	void multiplyComplex(double* i, double* q, const double* rec_i, const double* rec_q, size_t n)
+	{
+		for (size_t x = 0; x < n; x += 1)
+		{
+			double re = i[x] * rec_i[x] - q[x] * rec_q[x];
+			double im = i[x] * rec_q[x] + q[x] * rec_i[x];
+			i[x] = re;
+			q[x] = im;
+		}
+	}
+
+	bool ratioInput(ExtTask* et, const ComplexData out[NUM_OUTPUTS], ComplexData in[NUM_OUTPUTS])
+	{
+		{
+			std::lock_guard<std::mutex> guard(et->lock);
+			if (!et->ratio_mode)
+				return false;
+		}
+
+		// The division needs both halves of every requested path, and the whole
+		// of Ref; measure whatever the caller left out into our own buffers.
+		size_t n = sweepPoints(et);
+		std::copy(out, out + NUM_OUTPUTS, in);
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			bool wanted = x == 4 || in[x].I || in[x].Q;
+			if (wanted && !in[x].I)
+			{
+				et->ratio_i[x].resize(n);
+				in[x].I = et->ratio_i[x].data();
+			}
+			if (wanted && !in[x].Q)
+			{
+				et->ratio_q[x].resize(n);
+				in[x].Q = et->ratio_q[x].data();
+			}
+		}
+		return true;
+	}
+
+	void applyRatio(ExtTask* et, const ComplexData in[NUM_OUTPUTS])
+	{
+		size_t n = sweepPoints(et);
+		et->ratio_rec_i.resize(n);
+		et->ratio_rec_q.resize(n);
+		double* rec_i = et->ratio_rec_i.data();
+		double* rec_q = et->ratio_rec_q.data();
+
+		// One division per point, shared by the four paths.
+		referenceReciprocal(in[4].I, in[4].Q, rec_i, rec_q, n);
+		for (int x = 0; x < 4; x += 1)
+			if (in[x].I && in[x].Q)
+				multiplyComplex(in[x].I, in[x].Q, rec_i, rec_q, n);
+	}
+
+}
+
+ErrCode setRatioMode(TaskHandle t, const bool enabled)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->ratio_mode = enabled;
+	return ERR_OK;
+}
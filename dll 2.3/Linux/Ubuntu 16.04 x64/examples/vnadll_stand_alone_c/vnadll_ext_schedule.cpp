@@ -0,0 +1,217 @@
+// vnadll_ext_schedule.cpp : Fixed-cadence measurement scheduler.
+//
+
+#include <algorithm>
+#include <time.h>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+typedef std::chrono::steady_clock Clock;
+
+// Longest single sleep, so stopScheduledMeasurements() is noticed promptly even
+// with long periods.
+static const double MAX_SLEEP_SECONDS = 0.05;
+
+// Sleep until `deadline` on the monotonic clock. On Linux the wait is absolute
+// (TIMER_ABSTIME), so time spent before the call does not add to the jitter.
+static void sleepUntil(Clock::time_point deadline)
+{
+#ifdef LINUX
+	// steady_clock is CLOCK_MONOTONIC in libstdc++.
+	std::chrono::nanoseconds ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+	struct timespec ts;
+	ts.tv_sec = (time_t)(ns.count() / 1000000000);
+	ts.tv_nsec = (long)(ns.count() % 1000000000);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+		;
+#else
+	std::this_thread::sleep_until(deadline);
+#endif
+}
+
+static void runSchedule(ExtTask* et, MeasurementKind kind, double period, unsigned int points)
+{
+	Schedule& sched = et->schedule;
+	Clock::time_point origin = Clock::now();
+	Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period));
+	Clock::duration max_sleep = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(MAX_SLEEP_SECONDS));
+
+	ScheduledRecord scratch;
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		scratch.i[x].resize(points);
+		scratch.q[x].resize(points);
+	}
+
+	unsigned int slot = 0;
+	unsigned int missed = 0;
+	std::unique_lock<std::mutex> guard(et->lock);
+	while (!sched.stopping)
+	{
+		Clock::time_point scheduled = origin + step * slot;
+		guard.unlock();
+		bool stopping = false;
+		Clock::time_point now = Clock::now();
+		while (!stopping && scheduled - now > max_sleep)
+		{
+			sleepUntil(now + max_sleep);
+			guard.lock();
+			stopping = sched.stopping;
+			guard.unlock();
+			now = Clock::now();
+		}
+		if (stopping)
+		{
+			guard.lock();
+			break;
+		}
+		sleepUntil(scheduled);
+
+		ComplexData out[NUM_OUTPUTS];
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			out[x].I = scratch.i[x].data();
+			out[x].Q = scratch.q[x].data();
+		}
+		if (kind == MEAS_2PORT_CALIBRATED)
+			out[4].I = out[4].Q = NULL;
+
+		Clock::time_point actual = Clock::now();
+		ErrCode code = measureInto(et, kind, out);
+		Clock::time_point completed = Clock::now();
+		guard.lock();
+		if (sched.stopping)
+			break;
+
+		scratch.info.sequence = slot;
+		scratch.info.scheduled_seconds = std::chrono::duration<double>(scheduled - origin).count();
+		scratch.info.actual_seconds = std::chrono::duration<double>(actual - origin).count();
+		scratch.info.completed_seconds = std::chrono::duration<double>(completed - origin).count();
+		scratch.info.missed = missed;
+		scratch.info.result = code;
+
+		size_t depth = sched.queue.size();
+		if (sched.count == depth)
+		{
+			sched.head = (sched.head + 1) % depth;
+			sched.count -= 1;
+			sched.dropped += 1;
+		}
+		ScheduledRecord& rec = sched.queue[(sched.head + sched.count) % depth];
+		std::swap(rec.info, scratch.info);
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			rec.i[x].swap(scratch.i[x]);
+			rec.q[x].swap(scratch.q[x]);
+			scratch.i[x].resize(points);
+			scratch.q[x].resize(points);
+		}
+		sched.count += 1;
+		et->signalCompletion();
+
+		// Slots that started while this measurement was running are skipped rather
+		// than fired late back to back.
+		unsigned int next = (unsigned int)((completed - origin) / step) + 1;
+		missed = next - slot - 1;
+		slot = next;
+	}
+
+	sched.running = false;
+	et->in_flight = false;
+	et->cv.notify_all();
+}
+
+ErrCode startScheduledMeasurements(TaskHandle t, const MeasurementKind kind, const double period_seconds,
+                                   const unsigned int queue_depth)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (kind != MEAS_UNCALIBRATED && kind != MEAS_2PORT_CALIBRATED)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (period_seconds <= 0 || queue_depth == 0)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (getState(t) != TASK_STARTED)
+		return ERR_WRONG_STATE;
+
+	ExtTask* et = getExtTask(t);
+	unsigned int points;
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		if (et->in_flight || et->submitted)
+			return ERR_WRONG_STATE;
+		if (kind == MEAS_2PORT_CALIBRATED && !et->lazy_factory_cal && !isCalibrationComplete(t))
+			return ERR_BAD_CAL;
+
+		points = resultPoints(et);
+		Schedule& sched = et->schedule;
+		sched.queue.assign(queue_depth, ScheduledRecord());
+		sched.head = 0;
+		sched.count = 0;
+		sched.dropped = 0;
+		sched.kind = kind;
+		sched.stopping = false;
+		sched.running = true;
+		et->in_flight = true;
+		et->points = points;
+		et->drainCompletion();
+	}
+
+	ioPool().submit([et, kind, period_seconds, points] { runSchedule(et, kind, period_seconds, points); });
+	return ERR_OK;
+}
+
+ErrCode stopScheduledMeasurements(TaskHandle t)
+{
+	ExtTask* et = findExtTask(t);
+	if (!et)
+		return ERR_WRONG_STATE;
+
+	std::unique_lock<std::mutex> guard(et->lock);
+	if (!et->schedule.running)
+		return ERR_WRONG_STATE;
+
+	et->schedule.stopping = true;
+	interruptMeasurement(t);
+	et->cv.wait(guard, [et] { return !et->schedule.running; });
+	return ERR_OK;
+}
+
+ErrCode reapScheduledMeasurement(TaskHandle t, ScheduledResult* info, unsigned int* dropped,
+                                 ComplexData out0, ComplexData out1,
+                                 ComplexData out2, ComplexData out3,
+                                 ComplexData out4)
+{
+	ExtTask* et = findExtTask(t);
+	if (!et)
+		return ERR_WRONG_STATE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	Schedule& sched = et->schedule;
+	if (sched.count == 0)
+		return ERR_WRONG_STATE;
+
+	ScheduledRecord& rec = sched.queue[sched.head];
+	ComplexData out[NUM_OUTPUTS] = { out0, out1, out2, out3, out4 };
+	if (sched.kind == MEAS_2PORT_CALIBRATED)
+		out[4].I = out[4].Q = NULL;
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		if (out[x].I)
+			std::copy(rec.i[x].begin(), rec.i[x].end(), out[x].I);
+		if (out[x].Q)
+			std::copy(rec.q[x].begin(), rec.q[x].end(), out[x].Q);
+	}
+	if (info)
+		*info = rec.info;
+	if (dropped)
+		*dropped = sched.dropped;
+	sched.dropped = 0;
+
+	sched.head = (sched.head + 1) % sched.queue.size();
+	sched.count -= 1;
+	if (sched.count == 0)
+		et->drainCompletion();
+	return ERR_OK;
+}
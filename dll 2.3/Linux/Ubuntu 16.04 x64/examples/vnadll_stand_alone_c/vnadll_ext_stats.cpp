@@ -0,0 +1,209 @@
+// vnadll_ext_stats.cpp : Running per-point statistics over many sweeps.
+//
+
+#include <algorithm>
+#include <math.h>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+namespace vnaext
+{
+
+	// Welford accumulator for one output. Minimum and maximum are kept as squared
+	// magnitudes, so the update needs no square root.
+	struct OutputStatistics
+	{
+		OutputStatistics() : sweeps(0) {}
+
+		unsigned int        sweeps;
+		std::vector<double> mean_i;
+		std::vector<double> mean_q;
+		std::vector<double> m2;       // sum of |x - mean|^2
+		std::vector<double> min_mag2;
+		std::vector<double> max_mag2;
+	};
+
+	struct Statistics
+	{
+		Statistics() : points(0), skipped(false) {}
+
+		std::mutex       lock;
+		size_t           points;      // 0 until the first sweep
+		bool             skipped;     // a Task measurement had the wrong number of points
+		OutputStatistics outputs[NUM_OUTPUTS];
+	};
+
+	static void update(OutputStatistics& s, const double* in_i, const double* in_q, size_t N)
+	{
+		s.sweeps += 1;
+		double weight = 1.0 / s.sweeps;
+		double* mean_i = s.mean_i.data();
+		double* mean_q = s.mean_q.data();
+		double* m2 = s.m2.data();
+		double* min_mag2 = s.min_mag2.data();
+		double* max_mag2 = s.max_mag2.data();
+
+		for (size_t n = 0; n < N; n += 1)
+		{
+			double di = in_i[n] - mean_i[n];
+			double dq = in_q[n] - mean_q[n];
+			mean_i[n] += di * weight;
+			mean_q[n] += dq * weight;
+			m2[n] += di * (in_i[n] - mean_i[n]) + dq * (in_q[n] - mean_q[n]);
+
+			double mag2 = in_i[n] * in_i[n] + in_q[n] * in_q[n];
+			min_mag2[n] = std::min(min_mag2[n], mag2);
+			max_mag2[n] = std::max(max_mag2[n], mag2);
+		}
+	}
+
+	static ErrCode add(Statistics& stats, size_t N, const ComplexData in[NUM_OUTPUTS])
+	{
+		std::lock_guard<std::mutex> guard(stats.lock);
+		if (stats.points == 0)
+		{
+			stats.points = N;
+			for (int x = 0; x < NUM_OUTPUTS; x += 1)
+			{
+				OutputStatistics& s = stats.outputs[x];
+				s.mean_i.assign(N, 0);
+				s.mean_q.assign(N, 0);
+				s.m2.assign(N, 0);
+				s.min_mag2.assign(N, INFINITY);
+				s.max_mag2.assign(N, 0);
+			}
+		}
+		if (N != stats.points)
+			return ERR_MISSING_FREQS;
+
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+			if (in[x].I && in[x].Q)
+				update(stats.outputs[x], in[x].I, in[x].Q, N);
+		return ERR_OK;
+	}
+
+	void feedStatistics(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+	{
+		std::shared_ptr<Statistics> stats;
+		{
+			std::lock_guard<std::mutex> guard(et->lock);
+			stats = et->statistics;
+		}
+		if (!stats)
+			return;
+
+		ComplexData in[NUM_OUTPUTS];
+		std::copy(out, out + NUM_OUTPUTS, in);
+		if (kind == MEAS_2PORT_CALIBRATED)
+			in[4].I = in[4].Q = NULL;
+		if (add(*stats, resultPoints(et), in) != ERR_OK)
+		{
+			// The measurement itself succeeded; report the mismatch through
+			// getStatistics() instead.
+			std::lock_guard<std::mutex> guard(stats->lock);
+			stats->skipped = true;
+		}
+	}
+
+}
+
+// The handle keeps the accumulator alive; a Task it is attached to holds
+// another reference, so deleting the handle first is safe.
+struct statistics_t
+{
+	std::shared_ptr<Statistics> stats;
+};
+
+StatisticsHandle createStatistics()
+{
+	StatisticsHandle s = new statistics_container;
+	s->stats.reset(new Statistics);
+	return s;
+}
+
+void deleteStatistics(StatisticsHandle s)
+{
+	delete s;
+}
+
+ErrCode resetStatistics(StatisticsHandle s)
+{
+	if (!s)
+		return ERR_BAD_HANDLE;
+
+	Statistics& stats = *s->stats;
+	std::lock_guard<std::mutex> guard(stats.lock);
+	stats.points = 0;
+	stats.skipped = false;
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		stats.outputs[x].sweeps = 0;
+	return ERR_OK;
+}
+
+ErrCode addToStatistics(StatisticsHandle s, const unsigned int N,
+                        ComplexData out0, ComplexData out1,
+                        ComplexData out2, ComplexData out3,
+                        ComplexData out4)
+{
+	if (!s)
+		return ERR_BAD_HANDLE;
+	if (N == 0)
+		return ERR_MISSING_FREQS;
+
+	ComplexData in[NUM_OUTPUTS] = { out0, out1, out2, out3, out4 };
+	return add(*s->stats, N, in);
+}
+
+ErrCode attachStatistics(TaskHandle t, StatisticsHandle s)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (s)
+		et->statistics = s->stats;
+	else
+		et->statistics.reset();
+	return ERR_OK;
+}
+
+ErrCode getStatistics(StatisticsHandle s, const unsigned int output, unsigned int* sweeps,
+                      ComplexData mean, double* variance,
+                      double* min_magnitude, double* max_magnitude)
+{
+	if (!s)
+		return ERR_BAD_HANDLE;
+	if (output >= (unsigned int)NUM_OUTPUTS)
+		return ERR_BAD_PATH;
+
+	Statistics& stats = *s->stats;
+	std::lock_guard<std::mutex> guard(stats.lock);
+	const OutputStatistics& o = stats.outputs[output];
+	ErrCode code = stats.skipped ? ERR_MISSING_FREQS : ERR_OK;
+	if (sweeps)
+		*sweeps = o.sweeps;
+	if (o.sweeps == 0)
+		return code;
+
+	size_t N = stats.points;
+	if (mean.I)
+		std::copy(o.mean_i.begin(), o.mean_i.begin() + N, mean.I);
+	if (mean.Q)
+		std::copy(o.mean_q.begin(), o.mean_q.begin() + N, mean.Q);
+	if (variance)
+	{
+		double scale = o.sweeps > 1 ? 1.0 / (o.sweeps - 1) : 0;
+		for (size_t n = 0; n < N; n += 1)
+			variance[n] = o.m2[n] * scale;
+	}
+	if (min_magnitude)
+		for (size_t n = 0; n < N; n += 1)
+			min_magnitude[n] = sqrt(o.min_mag2[n]);
+	if (max_magnitude)
+		for (size_t n = 0; n < N; n += 1)
+			max_magnitude[n] = sqrt(o.max_mag2[n]);
+	return code;
+}
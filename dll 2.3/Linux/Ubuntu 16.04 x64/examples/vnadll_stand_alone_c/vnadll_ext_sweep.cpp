@@ -0,0 +1,647 @@
+// vnadll_ext_sweep.cpp : Segmented sweeps, and the measurement path shared by
+// all of the extension measurement functions.
+//
+
+#include <algorithm>
+
+#include "vnadll_ext_internal.h"
+
+using namespace vnaext;
+
+FrequencyOrder ORDER_AS_GIVEN      = 0;
+FrequencyOrder ORDER_GROUP_BY_BAND = 1;
+FrequencyOrder ORDER_ASCENDING     = 2;
+
+// Offset every non-null output pointer by `offset` points.
+static void offsetOutputs(const ComplexData in[NUM_OUTPUTS], size_t offset, ComplexData out[NUM_OUTPUTS])
+{
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		out[x].I = in[x].I ? in[x].I + offset : NULL;
+		out[x].Q = in[x].Q ? in[x].Q + offset : NULL;
+	}
+}
+
+static ErrCode measureProgrammed(TaskHandle t, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+{
+	if (kind == MEAS_2PORT_CALIBRATED)
+		return measure2PortCalibrated(t, out[0], out[1], out[2], out[3]);
+	return measureUncalibrated(t, out[0], out[1], out[2], out[3], out[4]);
+}
+
+// Set by cancelMeasurement(). Checked before every DLL measurement call, since an
+// interrupt issued while a segment is being loaded (the Task is stopped) is
+// rejected by the DLL.
+static bool abortRequested(ExtTask* et)
+{
+	std::lock_guard<std::mutex> guard(et->lock);
+	return et->abort;
+}
+
+// Check that segment `k` is what the Task has programmed. This asks the DLL rather
+// than trusting `plan.loaded`, since the caller may have stopped and restarted the
+// Task in between sweeps.
+static bool segmentProgrammed(ExtTask* et, int k)
+{
+	SweepPlan& plan = et->plan;
+	if (getState(et->handle) != TASK_STARTED)
+		return false;
+
+	const Segment& seg = plan.segments[k];
+	if (seg.hop != HOP_UNDEFINED && getHopRate(et->handle) != seg.hop)
+		return false;
+	if (seg.atten != ATTEN_UNDEFINED && getAttenuation(et->handle) != seg.atten)
+		return false;
+
+	const std::vector<double>& freqs = seg.freqs;
+	if (getNumberOfFrequencies(et->handle) != freqs.size())
+		return false;
+
+	plan.scratch.resize(freqs.size());
+	getFrequencies(et->handle, plan.scratch.data(), (int)plan.scratch.size());
+	return plan.scratch == freqs;
+}
+
+// Split segment `k` into two halves. Output offsets are unchanged.
+static void splitSegment(SweepPlan& plan, int k)
+{
+	Segment& seg = plan.segments[k];
+	size_t half = seg.freqs.size() / 2;
+
+	Segment tail;
+	tail.freqs.assign(seg.freqs.begin() + half, seg.freqs.end());
+	tail.offset = seg.offset + half;
+	tail.hop = seg.hop;
+	tail.atten = seg.atten;
+	seg.freqs.resize(half);
+
+	plan.segments.insert(plan.segments.begin() + k + 1, tail);
+	plan.loaded = -1;
+}
+
+// Program segment `k`. Sets `*split` if the segment overflowed and was split.
+static ErrCode loadSegment(ExtTask* et, int k, bool* split)
+{
+	SweepPlan& plan = et->plan;
+	TaskHandle t = et->handle;
+	*split = false;
+
+	if (segmentProgrammed(et, k))
+	{
+		plan.loaded = k;
+		return ERR_OK;
+	}
+
+	plan.loaded = -1;
+	if (getState(t) == TASK_STARTED)
+	{
+		ErrCode code = stop(t);
+		if (code != ERR_OK)
+			return code;
+	}
+
+	const Segment& seg = plan.segments[k];
+	ErrCode code = setFrequencies(t, seg.freqs.data(), (unsigned int)seg.freqs.size());
+	if (code == ERR_OK && seg.hop != HOP_UNDEFINED)
+		code = setHopRate(t, seg.hop);
+	if (code == ERR_OK && seg.atten != ATTEN_UNDEFINED)
+		code = setAttenuation(t, seg.atten);
+	if (code != ERR_OK)
+		return code;
+
+	code = start(t);
+	if (code == ERR_PROG_OVERFLOW && seg.freqs.size() > 1)
+	{
+		splitSegment(plan, k);
+		*split = true;
+		return ERR_OK;
+	}
+	if (code != ERR_OK)
+		return code;
+
+	plan.loaded = k;
+	return ERR_OK;
+}
+
+static ErrCode measurePlan(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+{
+	SweepPlan& plan = et->plan;
+
+	while (true)
+	{
+		// Serpentine order: pick up from whichever end is already programmed.
+		int count = (int)plan.segments.size();
+		bool reverse = count > 1 && plan.loaded == count - 1;
+		bool split = false;
+
+		for (int x = 0; x < count && !split; x += 1)
+		{
+			int k = reverse ? count - 1 - x : x;
+			if (abortRequested(et))
+				return ERR_INTERRUPTED;
+			ErrCode code = loadSegment(et, k, &split);
+			if (code != ERR_OK)
+				return code;
+			if (split)
+				break;
+			if (abortRequested(et))
+				return ERR_INTERRUPTED;
+
+			ComplexData seg_out[NUM_OUTPUTS];
+			offsetOutputs(out, plan.segments[k].offset, seg_out);
+			code = measureProgrammed(et->handle, kind, seg_out);
+			if (code != ERR_OK)
+				return code;
+		}
+
+		if (!split)
+			return ERR_OK;
+	}
+}
+
+// Move the points of every output array from programmed order to output order.
+static void unpermuteOutputs(SweepPlan& plan, const ComplexData out[NUM_OUTPUTS])
+{
+	const unsigned int* index = plan.index.data();
+	size_t n = plan.index.size();
+	plan.unpermute.resize(n);
+	double* tmp = plan.unpermute.data();
+
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		double* arrays[2] = { out[x].I, out[x].Q };
+		for (int y = 0; y < 2; y += 1)
+		{
+			double* arr = arrays[y];
+			if (!arr)
+				continue;
+			for (size_t z = 0; z < n; z += 1)
+				tmp[index[z]] = arr[z];
+			std::copy(tmp, tmp + n, arr);
+		}
+	}
+}
+
+// Band boundaries are listed highest first, so the lowest band gets the highest index.
+int vnaext::bandOf(const HardwareDetails& details, double freq)
+{
+	int band = 0;
+	for (int x = 0; x < details.number_of_band_boundaries && x < 8; x += 1)
+		if (freq < details.band_boundaries[x])
+			band += 1;
+	return band;
+}
+
+std::vector<unsigned int> vnaext::pointOrder(TaskHandle t, FrequencyOrder ordering,
+                                             const double* freqs, unsigned int N)
+{
+	std::vector<unsigned int> order;
+	if (ordering != ORDER_GROUP_BY_BAND && ordering != ORDER_ASCENDING)
+		return order;
+
+	order.resize(N);
+	for (unsigned int x = 0; x < N; x += 1)
+		order[x] = x;
+
+	if (ordering == ORDER_ASCENDING)
+	{
+		std::stable_sort(order.begin(), order.end(),
+		                 [freqs](unsigned int a, unsigned int b) { return freqs[a] < freqs[b]; });
+	}
+	else
+	{
+		HardwareDetails details = getHardwareDetails(t);
+		std::vector<int> band(N);
+		for (unsigned int x = 0; x < N; x += 1)
+			band[x] = bandOf(details, freqs[x]);
+		std::stable_sort(order.begin(), order.end(),
+		                 [&band](unsigned int a, unsigned int b) { return band[a] > band[b]; });
+	}
+	return order;
+}
+
+namespace vnaext
+{
+
+	unsigned int sweepPoints(ExtTask* et)
+	{
+		if (et->plan.active)
+			return (unsigned int)et->plan.freqs.size();
+		return getNumberOfFrequencies(et->handle);
+	}
+
+	bool sweepSpan(ExtTask* et, double* lo, double* hi)
+	{
+		std::vector<double> freqs;
+		if (et->plan.active)
+			freqs = et->plan.freqs;
+		else
+		{
+			freqs.resize(getNumberOfFrequencies(et->handle));
+			getFrequencies(et->handle, freqs.data(), (int)freqs.size());
+		}
+		if (freqs.empty())
+			return false;
+
+		*lo = *std::min_element(freqs.begin(), freqs.end());
+		*hi = *std::max_element(freqs.begin(), freqs.end());
+		return true;
+	}
+
+	ErrCode measureSweep(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+	{
+		if (!et->plan.active)
+		{
+			if (abortRequested(et))
+				return ERR_INTERRUPTED;
+			return measureProgrammed(et->handle, kind, out);
+		}
+
+		ErrCode code = measurePlan(et, kind, out);
+		if (code == ERR_OK && !et->plan.index.empty())
+			unpermuteOutputs(et->plan, out);
+		return code;
+	}
+
+	ErrCode measureRaw(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+	{
+		if (getState(et->handle) != TASK_STARTED)
+			return ERR_WRONG_STATE;
+
+		if (kind == MEAS_2PORT_CALIBRATED)
+		{
+			ErrCode code = ensureCalibration(et);
+			if (code != ERR_OK)
+				return code;
+		}
+
+		ComplexData ratio[NUM_OUTPUTS];
+		bool ratio_mode = kind == MEAS_UNCALIBRATED && ratioInput(et, out, ratio);
+		const ComplexData* sweep = ratio_mode ? ratio : out;
+
+		ErrCode code = measureAveraged(et, kind, sweep);
+		if (code == ERR_OK && ratio_mode)
+			applyRatio(et, sweep);
+		return code;
+	}
+
+	ErrCode applyCorrections(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+	{
+		if (kind == MEAS_UNCALIBRATED)
+			return applyBaseline(et, out);
+		return applyDeembedding(et, out);
+	}
+
+	void feedAccumulators(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+	{
+		feedStatistics(et, kind, out);
+		feedDoppler(et, out);
+	}
+
+	ErrCode measureInto(ExtTask* et, MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+	{
+		// With a pipeline, the sweep is measured into its input buffers, since
+		// the pipeline may change the number of points.
+		ComplexData raw[NUM_OUTPUTS];
+		bool pipeline = pipelineInput(et, kind, raw);
+		const ComplexData* sweep = pipeline ? raw : out;
+
+		ErrCode code = measureRaw(et, kind, sweep);
+		if (code == ERR_OK)
+			code = applyCorrections(et, kind, sweep);
+		if (code == ERR_OK && pipeline)
+			runPipeline(et, kind, raw, out);
+		if (code == ERR_OK)
+			feedAccumulators(et, kind, out);
+		return code;
+	}
+
+}
+
+// Build a plan from a flat point list. Runs of points that share a hop rate and
+// attenuation are packed into programs of up to `HardwareDetails.maximum_points`.
+// `hops` and `attens` may be NULL, in which case the Task settings are kept.
+// On return the first segment is set on the Task, so start() programs it.
+static ErrCode compilePlan(TaskHandle t, const double* freqs, const HopRate* hops,
+                           const Attenuation* attens, unsigned int N, SweepPlan* plan)
+{
+	if (N == 0 || !freqs)
+		return ERR_MISSING_FREQS;
+	if (getState(t) != TASK_STOPPED)
+		return ERR_WRONG_STATE;
+
+	HardwareDetails details = getHardwareDetails(t);
+	if (details.maximum_points <= 0)
+		return ERR_WRONG_STATE;
+	unsigned int max_points = (unsigned int)details.maximum_points;
+
+	unsigned int offset = 0;
+	while (offset < N)
+	{
+		HopRate hop = hops ? hops[offset] : HOP_UNDEFINED;
+		Attenuation atten = attens ? attens[offset] : ATTEN_UNDEFINED;
+
+		unsigned int n = 1;
+		while (offset + n < N && n < max_points
+		       && (!hops || hops[offset + n] == hop)
+		       && (!attens || attens[offset + n] == atten))
+			n += 1;
+
+		ErrCode code = setFrequencies(t, freqs + offset, n);
+		if (code != ERR_OK)
+			return code;
+
+		Segment seg;
+		seg.freqs.resize(n);
+		seg.offset = offset;
+		seg.hop = hop;
+		seg.atten = atten;
+		getFrequencies(t, seg.freqs.data(), (int)n);
+		plan->freqs.insert(plan->freqs.end(), seg.freqs.begin(), seg.freqs.end());
+		plan->segments.push_back(seg);
+
+		offset += n;
+	}
+
+	const Segment& first = plan->segments[0];
+	ErrCode code = ERR_OK;
+	if (plan->segments.size() > 1)
+		code = setFrequencies(t, first.freqs.data(), (unsigned int)first.freqs.size());
+	if (code == ERR_OK && first.hop != HOP_UNDEFINED)
+		code = setHopRate(t, first.hop);
+	if (code == ERR_OK && first.atten != ATTEN_UNDEFINED)
+		code = setAttenuation(t, first.atten);
+	if (code != ERR_OK)
+		return code;
+
+	plan->active = true;
+	return ERR_OK;
+}
+
+ErrCode vnaext::loadPlan(ExtTask* et, const double* freqs, unsigned int N)
+{
+	if (!freqs)
+		return ERR_MISSING_FREQS;
+
+	TaskHandle t = et->handle;
+	std::vector<unsigned int> order = pointOrder(t, et->ordering, freqs, N);
+	if (order.empty())
+	{
+		SweepPlan plan;
+		ErrCode code = compilePlan(t, freqs, NULL, NULL, N, &plan);
+		if (code == ERR_OK)
+			et->plan = plan;
+		return code;
+	}
+
+	std::vector<double> programmed(N);
+	for (unsigned int x = 0; x < N; x += 1)
+		programmed[x] = freqs[order[x]];
+
+	SweepPlan plan;
+	ErrCode code = compilePlan(t, programmed.data(), NULL, NULL, N, &plan);
+	if (code != ERR_OK)
+		return code;
+
+	// compilePlan() stitched the frequencies in programmed order.
+	for (unsigned int x = 0; x < N; x += 1)
+		programmed[order[x]] = plan.freqs[x];
+	plan.freqs.swap(programmed);
+	plan.index.swap(order);
+
+	et->plan = plan;
+	return ERR_OK;
+}
+
+ErrCode setSegmentedFrequencies(TaskHandle t, const double* freqs, const unsigned int N)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+
+	ExtTask* et = getExtTask(t);
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (et->in_flight)
+		return ERR_WRONG_STATE;
+
+	return loadPlan(et, freqs, N);
+}
+
+ErrCode setFrequencyOrdering(TaskHandle t, const FrequencyOrder ordering)
+{
+	if (ordering != ORDER_AS_GIVEN && ordering != ORDER_GROUP_BY_BAND && ordering != ORDER_ASCENDING)
+		return ERR_WRONG_PROGRAM_TYPE;
+
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->ordering = ordering;
+	return ERR_OK;
+}
+
+ErrCode setSweepSegments(TaskHandle t, const SweepSegment* segments, const unsigned int N)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (N == 0 || !segments)
+		return ERR_MISSING_FREQS;
+
+	HopRate task_hop = getHopRate(t);
+	Attenuation task_atten = getAttenuation(t);
+	HardwareDetails details = getHardwareDetails(t);
+	if (details.maximum_points <= 0)
+		return ERR_WRONG_STATE;
+	unsigned int max_points = (unsigned int)details.maximum_points;
+
+	std::vector<double> freqs;
+	std::vector<HopRate> hops;
+	std::vector<Attenuation> attens;
+	for (unsigned int x = 0; x < N; x += 1)
+	{
+		const SweepSegment& seg = segments[x];
+		if (seg.points == 0)
+			continue;
+
+		HopRate hop = seg.hop_rate != HOP_UNDEFINED ? seg.hop_rate : task_hop;
+		if (hop == HOP_UNDEFINED)
+			return ERR_MISSING_HOP;
+		Attenuation atten = seg.attenuation != ATTEN_UNDEFINED ? seg.attenuation : task_atten;
+
+		// Same end-point adjustment as utilGenerateLinearSweep(), so the points
+		// of every segment are equally spaced. utilFixLinearSweepLimits() only
+		// takes up to maximum_points, so a longer segment is adjusted in blocks
+		// of that size, each spanning its share of the segment's own start and
+		// stop; the last point of the segment is then its (adjusted) stop.
+		double nominal_step = seg.points > 1
+		                      ? (seg.stop_frequency - seg.start_frequency) / (seg.points - 1) : 0;
+		for (unsigned int first = 0; first < seg.points; first += max_points)
+		{
+			unsigned int count = std::min(seg.points - first, max_points);
+			double start_freq = seg.start_frequency + nominal_step * first;
+			double stop_freq = first + count == seg.points
+			                   ? seg.stop_frequency : seg.start_frequency + nominal_step * (first + count - 1);
+			ErrCode code = utilFixLinearSweepLimits(t, &start_freq, &stop_freq, count);
+			if (code != ERR_OK)
+				return code;
+
+			for (unsigned int y = 0; y < count; y += 1)
+			{
+				double frac = count > 1 ? (double)y / (count - 1) : 0;
+				freqs.push_back(start_freq + (stop_freq - start_freq) * frac);
+				hops.push_back(hop);
+				attens.push_back(atten);
+			}
+		}
+	}
+
+	ExtTask* et = getExtTask(t);
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (et->in_flight)
+		return ERR_WRONG_STATE;
+
+	SweepPlan plan;
+	ErrCode code = compilePlan(t, freqs.data(), hops.data(), attens.data(), (unsigned int)freqs.size(), &plan);
+	if (code == ERR_OK)
+		et->plan = plan;
+	return code;
+}
+
+ErrCode setPowerSweep(TaskHandle t, const double* freqs, const unsigned int N,
+                      const Attenuation* attens, const unsigned int M)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (!freqs || N == 0)
+		return ERR_MISSING_FREQS;
+	if (!attens || M == 0)
+		return ERR_MISSING_ATTEN;
+
+	// One block of `N` frequencies per attenuation step, so the stitched output
+	// is laid out as [step][frequency].
+	std::vector<double> block_freqs;
+	std::vector<Attenuation> block_attens;
+	block_freqs.reserve((size_t)N * M);
+	block_attens.reserve((size_t)N * M);
+	for (unsigned int x = 0; x < M; x += 1)
+	{
+		if (attens[x] == ATTEN_UNDEFINED)
+			return ERR_BAD_ATTEN;
+		block_freqs.insert(block_freqs.end(), freqs, freqs + N);
+		block_attens.insert(block_attens.end(), N, attens[x]);
+	}
+
+	ExtTask* et = getExtTask(t);
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (et->in_flight)
+		return ERR_WRONG_STATE;
+
+	SweepPlan plan;
+	ErrCode code = compilePlan(t, block_freqs.data(), NULL, block_attens.data(),
+	                           (unsigned int)block_freqs.size(), &plan);
+	if (code == ERR_OK)
+		et->plan = plan;
+	return code;
+}
+
+ErrCode clearSegmentedFrequencies(TaskHandle t)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (et->in_flight)
+		return ERR_WRONG_STATE;
+	et->plan = SweepPlan();
+	return ERR_OK;
+}
+
+unsigned int getSegmentedNumberOfFrequencies(TaskHandle t)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return 0;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	return sweepPoints(et);
+}
+
+ErrCode getSegmentedFrequencies(TaskHandle t, double* freqs, const unsigned int freqs_sz)
+{
+	ExtTask* et = getExtTask(t);
+	if (!et)
+		return ERR_BAD_HANDLE;
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	if (!et->plan.active)
+		return getFrequencies(t, freqs, (int)freqs_sz);
+
+	size_t n = std::min((size_t)freqs_sz, et->plan.freqs.size());
+	std::copy(et->plan.freqs.begin(), et->plan.freqs.begin() + n, freqs);
+	return ERR_OK;
+}
+
+// True if `out` cannot go straight to the DLL: measure2PortCalibrated() needs
+// both arrays of the four S-parameters, and neither measurement function
+// promises to fill one array of an output whose other array is NULL.
+static bool needsScratch(MeasurementKind kind, const ComplexData out[NUM_OUTPUTS])
+{
+	for (int x = 0; x < NUM_OUTPUTS; x += 1)
+	{
+		if (kind == MEAS_2PORT_CALIBRATED && x < 4 && (!out[x].I || !out[x].Q))
+			return true;
+		if (!out[x].I != !out[x].Q)
+			return true;
+	}
+	return false;
+}
+
+ErrCode measureSegmented(TaskHandle t, const MeasurementKind kind,
+                         ComplexData out0, ComplexData out1,
+                         ComplexData out2, ComplexData out3,
+                         ComplexData out4)
+{
+	if (!t)
+		return ERR_BAD_HANDLE;
+	if (kind != MEAS_UNCALIBRATED && kind != MEAS_2PORT_CALIBRATED)
+		return ERR_WRONG_PROGRAM_TYPE;
+
+	ExtTask* et = getExtTask(t);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		if (et->in_flight || et->submitted)
+			return ERR_WRONG_STATE;
+		et->in_flight = true;
+	}
+
+	// out4 is unused by calibrated measurements; keep it away from averaging
+	// and the accumulators, whatever the caller passed.
+	ComplexData out[NUM_OUTPUTS] = { out0, out1, out2, out3, out4 };
+	if (kind == MEAS_2PORT_CALIBRATED)
+		out[4].I = out[4].Q = NULL;
+
+	ErrCode code;
+	if (needsScratch(kind, out))
+	{
+		// Measure into the internal buffers and copy out the arrays the caller asked for.
+		{
+			std::lock_guard<std::mutex> guard(et->lock);
+			et->points = resultPoints(et);
+		}
+		ComplexData scratch[NUM_OUTPUTS];
+		bindBuffers(et, scratch);
+		if (kind == MEAS_2PORT_CALIBRATED)
+			scratch[4].I = scratch[4].Q = NULL;
+		code = measureInto(et, kind, scratch);
+		if (code == ERR_OK)
+			copyBuffers(et, out, et->points);
+	}
+	else
+		code = measureInto(et, kind, out);
+
+	std::lock_guard<std::mutex> guard(et->lock);
+	et->in_flight = false;
+	et->cv.notify_all();
+	return code;
+}
@@ -0,0 +1,208 @@
+// vnadll_ext_task.cpp : Per-Task extension state and the library worker pool.
+//
+
+#include <map>
+#include <memory>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#ifdef LINUX
+	#include <sys/eventfd.h>
+#endif
+
+#include "vnadll_ext_internal.h"
+
+MeasurementKind MEAS_UNCALIBRATED     = 1;
+MeasurementKind MEAS_2PORT_CALIBRATED = 2;
+
+namespace vnaext
+{
+
+	WorkerPool::WorkerPool(size_t max_threads)
+		: idle(0)
+		, max_threads(max_threads)
+		, stopping(false)
+	{
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		cv.notify_all();
+		for (size_t x = 0; x < threads.size(); x += 1)
+			threads[x].join();
+	}
+
+	void WorkerPool::submit(std::function<void()> job)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back(std::move(job));
+		if (jobs.size() > idle && (max_threads == 0 || threads.size() < max_threads))
+			threads.push_back(std::thread(&WorkerPool::run, this));
+		cv.notify_one();
+	}
+
+	void WorkerPool::run()
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		while (true)
+		{
+			idle += 1;
+			cv.wait(guard, [this] { return stopping || !jobs.empty(); });
+			idle -= 1;
+			if (jobs.empty())
+				return;
+
+			std::function<void()> job = std::move(jobs.front());
+			jobs.pop_front();
+
+			guard.unlock();
+			job();
+			guard.lock();
+		}
+	}
+
+	WorkerPool& ioPool()
+	{
+		static WorkerPool pool(0);
+		return pool;
+	}
+
+
+	ExtTask::ExtTask(TaskHandle t)
+		: handle(t)
+		, completion_fd(-1)
+		, submitted(false)
+		, in_flight(false)
+		, done(false)
+		, abandoned(false)
+		, queued(false)
+		, abort(false)
+		, kind(0)
+		, result(ERR_OK)
+		, points(0)
+		, ordering(ORDER_AS_GIVEN)
+		, ratio_mode(false)
+		, lazy_factory_cal(false)
+		, factory_cal_loaded(false)
+		, cal_points(0)
+		, cal_span_lo(0)
+		, cal_span_hi(0)
+		, initializing(false)
+		, init_done(false)
+		, init_result(ERR_OK)
+	{
+#ifdef LINUX
+		completion_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+	}
+
+	ExtTask::~ExtTask()
+	{
+		if (completion_fd >= 0)
+			close(completion_fd);
+	}
+
+	void ExtTask::signalCompletion()
+	{
+		if (completion_fd < 0)
+			return;
+		uint64_t one = 1;
+		ssize_t ret = write(completion_fd, &one, sizeof(one));
+		(void)ret;
+	}
+
+	void ExtTask::drainCompletion()
+	{
+		if (completion_fd < 0)
+			return;
+		uint64_t count;
+		ssize_t ret = read(completion_fd, &count, sizeof(count));
+		(void)ret;
+	}
+
+
+	static std::mutex& registryLock()
+	{
+		static std::mutex lock;
+		return lock;
+	}
+
+	static std::map<TaskHandle, std::unique_ptr<ExtTask> >& registry()
+	{
+		static std::map<TaskHandle, std::unique_ptr<ExtTask> > tasks;
+		return tasks;
+	}
+
+	ExtTask* getExtTask(TaskHandle t)
+	{
+		if (!t)
+			return NULL;
+
+		std::lock_guard<std::mutex> guard(registryLock());
+		std::unique_ptr<ExtTask>& et = registry()[t];
+		if (!et)
+			et.reset(new ExtTask(t));
+		return et.get();
+	}
+
+	ExtTask* findExtTask(TaskHandle t)
+	{
+		std::lock_guard<std::mutex> guard(registryLock());
+		std::map<TaskHandle, std::unique_ptr<ExtTask> >::iterator it = registry().find(t);
+		return it == registry().end() ? NULL : it->second.get();
+	}
+
+	void bindBuffers(ExtTask* et, ComplexData out[NUM_OUTPUTS])
+	{
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			et->buf_i[x].resize(et->points);
+			et->buf_q[x].resize(et->points);
+			out[x].I = et->buf_i[x].data();
+			out[x].Q = et->buf_q[x].data();
+		}
+	}
+
+	void copyBuffers(ExtTask* et, const ComplexData out[NUM_OUTPUTS], unsigned int n)
+	{
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			if (out[x].I)
+				memcpy(out[x].I, et->buf_i[x].data(), n * sizeof(double));
+			if (out[x].Q)
+				memcpy(out[x].Q, et->buf_q[x].data(), n * sizeof(double));
+		}
+	}
+
+}
+
+
+void deleteTaskExtensions(TaskHandle t)
+{
+	using namespace vnaext;
+
+	std::unique_ptr<ExtTask> et;
+	{
+		std::lock_guard<std::mutex> guard(registryLock());
+		std::map<TaskHandle, std::unique_ptr<ExtTask> >::iterator it = registry().find(t);
+		if (it == registry().end())
+			return;
+		et = std::move(it->second);
+		registry().erase(it);
+	}
+
+	std::unique_lock<std::mutex> guard(et->lock);
+	if (et->cw.running || et->schedule.running)
+	{
+		et->cw.stopping = true;
+		et->schedule.stopping = true;
+		et->cv.notify_all();
+		interruptMeasurement(t);
+	}
+	et->cv.wait(guard, [&et] { return !et->in_flight; });
+}
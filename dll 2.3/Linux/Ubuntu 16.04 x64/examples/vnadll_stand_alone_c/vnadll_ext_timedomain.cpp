@@ -0,0 +1,219 @@
+// vnadll_ext_timedomain.cpp : Frequency to time domain transform.
+//
+
+#include <math.h>
+#include <string.h>
+
+#include "vnadll_ext_dsp.h"
+
+using namespace vnaext;
+
+TimeDomainMode TD_BANDPASS = 1;
+TimeDomainMode TD_LOWPASS  = 2;
+
+WindowType WINDOW_RECT     = 0;
+WindowType WINDOW_HANN     = 1;
+WindowType WINDOW_HAMMING  = 2;
+WindowType WINDOW_BLACKMAN = 3;
+WindowType WINDOW_KAISER   = 4;
+
+// Number of transform plans kept in the cache.
+static const size_t PLAN_CACHE_SIZE = 16;
+
+// Everything a plan depends on. The frequency list is reduced to its first point,
+// spacing and length, since only evenly spaced lists are accepted.
+struct PlanKey
+{
+	int          mode;
+	int          window;
+	double       window_parameter;
+	double       start_time;
+	double       stop_time;
+	unsigned int points;
+	unsigned int n;
+	double       f0;
+	double       df;
+
+	bool operator==(const PlanKey& other) const
+	{
+		return mode == other.mode && window == other.window
+		       && window_parameter == other.window_parameter
+		       && start_time == other.start_time && stop_time == other.stop_time
+		       && points == other.points && n == other.n && f0 == other.f0 && df == other.df;
+	}
+};
+
+struct TimeDomainPlan
+{
+	std::unique_ptr<ChirpZ> czt;
+	unsigned int            harmonic0;  // TD_LOWPASS: harmonic number of the first frequency
+	std::vector<double>     times;
+};
+
+// Build the chirp-Z plan for `key`. Frequencies are in MHz, times in seconds.
+static std::shared_ptr<const TimeDomainPlan> buildPlan(const PlanKey& key)
+{
+	std::shared_ptr<TimeDomainPlan> plan(new TimeDomainPlan());
+
+	double df = key.df * 1e6;
+	double t0 = key.start_time;
+	double dt;
+	if (key.start_time == key.stop_time)
+	{
+		// Default: the whole alias-free range, zero padded to `points` samples.
+		t0 = 0;
+		dt = 1 / (df * key.points);
+	}
+	else
+		dt = key.points > 1 ? (key.stop_time - key.start_time) / (key.points - 1) : 0;
+
+	plan->times.resize(key.points);
+	for (unsigned int m = 0; m < key.points; m += 1)
+		plan->times[m] = t0 + m * dt;
+
+	// Band-pass transforms the measured bins as they are. Low-pass transforms the
+	// harmonic grid 0, df, 2 df, ... as the positive half of a Hermitian spectrum;
+	// bin 0 carries half the DC value, so twice the real part of the sum is the
+	// (real) impulse response.
+	size_t n_in;
+	double f_first;
+	if (key.mode == TD_LOWPASS)
+	{
+		plan->harmonic0 = (unsigned int)nearbyint(key.f0 / key.df);
+		n_in = plan->harmonic0 + key.n;
+		f_first = 0;
+	}
+	else
+	{
+		plan->harmonic0 = 0;
+		n_in = key.n;
+		f_first = key.f0 * 1e6;
+	}
+
+	std::vector<double> weight(n_in);
+	double total = 0;
+	for (size_t n = 0; n < n_in; n += 1)
+	{
+		double x;
+		if (key.mode == TD_LOWPASS)
+			x = n_in > 1 ? 0.5 + 0.5 * n / (n_in - 1) : 0.5;  // right half of a window centered on DC
+		else
+			x = n_in > 1 ? (double)n / (n_in - 1) : 0.5;
+		weight[n] = windowValue(key.window, key.window_parameter, x);
+		total += (key.mode == TD_LOWPASS && n > 0) ? 2 * weight[n] : weight[n];
+	}
+
+	std::vector<cplx> pre(n_in);
+	for (size_t n = 0; n < n_in; n += 1)
+		pre[n] = weight[n] / total * std::polar(1.0, 2 * M_PI * n * df * t0);
+	if (key.mode == TD_LOWPASS)
+		pre[0] *= 0.5;
+
+	std::vector<cplx> post(key.points);
+	for (unsigned int m = 0; m < key.points; m += 1)
+		post[m] = std::polar(1.0, 2 * M_PI * f_first * plan->times[m]);
+
+	plan->czt.reset(new ChirpZ(n_in, key.points, 2 * M_PI * df * dt, pre, post));
+	return plan;
+}
+
+// Transform one trace with `plan`. `scratch` holds the input and the chirp-Z work area.
+static void transformTrace(const TimeDomainPlan& plan, TimeDomainMode mode, ComplexData in, unsigned int N,
+                           ComplexData out, std::vector<cplx>& input, std::vector<cplx>& work,
+                           std::vector<cplx>& result)
+{
+	size_t n_in = plan.czt->inputSize();
+	size_t h0 = plan.harmonic0;
+	input.resize(n_in);
+	for (size_t n = 0; n < N; n += 1)
+		input[h0 + n] = cplx(in.I[n], in.Q[n]);
+
+	if (mode == TD_LOWPASS)
+	{
+		// Extrapolate the bins below the first measured frequency linearly; DC
+		// must be real for the impulse response to be real.
+		cplx first = input[h0];
+		cplx slope = N > 1 ? input[h0 + 1] - first : cplx(0, 0);
+		for (size_t n = 0; n < h0; n += 1)
+			input[n] = first - slope * (double)(h0 - n);
+		input[0] = cplx(input[0].real(), 0);
+	}
+
+	result.resize(plan.czt->outputSize());
+	plan.czt->run(input.data(), result.data(), work);
+
+	for (size_t m = 0; m < result.size(); m += 1)
+	{
+		if (mode == TD_LOWPASS)
+		{
+			out.I[m] = 2 * result[m].real();
+			if (out.Q)
+				out.Q[m] = 0;
+		}
+		else
+		{
+			out.I[m] = result[m].real();
+			if (out.Q)
+				out.Q[m] = result[m].imag();
+		}
+	}
+}
+
+ErrCode timeDomainTransform(const double* freqs, const unsigned int N,
+                            const ComplexData* in, const unsigned int traces,
+                            const TimeDomainConfig* config,
+                            ComplexData* out, double* times)
+{
+	if (!config || !in || !out || config->points == 0)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (config->mode != TD_BANDPASS && config->mode != TD_LOWPASS)
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (!validWindow(config->window))
+		return ERR_WRONG_PROGRAM_TYPE;
+	if (!freqs || N < 2)
+		return ERR_MISSING_FREQS;
+	for (unsigned int x = 0; x < traces; x += 1)
+		if (!in[x].I || !in[x].Q || !out[x].I)
+			return ERR_WRONG_PROGRAM_TYPE;
+
+	// The transform needs evenly spaced points; low-pass also needs them on a
+	// harmonic grid (every frequency a multiple of the spacing).
+	double df = (freqs[N - 1] - freqs[0]) / (N - 1);
+	if (df <= 0)
+		return ERR_MISSING_FREQS;
+	for (unsigned int n = 0; n < N; n += 1)
+		if (fabs(freqs[n] - (freqs[0] + n * df)) > df * 1e-3)
+			return ERR_MISSING_FREQS;
+	if (config->mode == TD_LOWPASS)
+	{
+		double harmonic = freqs[0] / df;
+		if (harmonic < 0.5 || fabs(harmonic - nearbyint(harmonic)) > 1e-3)
+			return ERR_MISSING_FREQS;
+	}
+
+	PlanKey key;
+	key.mode = config->mode;
+	key.window = config->window;
+	key.window_parameter = config->window == WINDOW_KAISER ? config->window_parameter : 0;
+	key.start_time = config->start_time;
+	key.stop_time = config->stop_time;
+	key.points = config->points;
+	key.n = N;
+	key.f0 = freqs[0];
+	key.df = df;
+	static PlanCache<PlanKey, TimeDomainPlan> cache(PLAN_CACHE_SIZE);
+	std::shared_ptr<const TimeDomainPlan> plan = cache.find(key, buildPlan);
+
+	if (times)
+		memcpy(times, plan->times.data(), plan->times.size() * sizeof(double));
+
+	TimeDomainMode mode = config->mode;
+	parallelFor(traces, [&](size_t x)
+	{
+		std::vector<cplx> input;
+		std::vector<cplx> work;
+		std::vector<cplx> result;
+		transformTrace(*plan, mode, in[x], N, out[x], input, work, result);
+	});
+	return ERR_OK;
+}
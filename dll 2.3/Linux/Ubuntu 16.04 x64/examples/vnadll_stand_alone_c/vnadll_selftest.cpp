@@ -0,0 +1,726 @@
+// vnadll_selftest.cpp : Deterministic self-checks of the host-side extensions
+// (vnadll_ext.h). Each result is compared with a direct computation or a closed
+// form; no hardware is needed. Run with `./build.sh ext_selftest`.
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <thread>
+#include <vector>
+#include "vna_header_agg_c.h"
+#include "vnadll_ext.h"
+#include "vnadll_ext_dsp.h"
+
+using namespace vnaext;
+
+static int failures = 0;
+
+// Report `name`, which passes if `error` is within `tolerance` (NaN fails).
+static void check(const char* name, double error, double tolerance)
+{
+	bool pass = error <= tolerance;
+	printf("%-52s %s (error %.3g)\n", name, pass ? "PASS" : "FAIL", error);
+	if (!pass)
+		failures += 1;
+}
+
+static void checkCode(const char* name, ErrCode code, ErrCode expected)
+{
+	bool pass = code == expected;
+	printf("%-52s %s (code %d)\n", name, pass ? "PASS" : "FAIL", (int)code);
+	if (!pass)
+		failures += 1;
+}
+
+// Deterministic pseudo-random value in [-1, 1).
+static double noise(unsigned int& state)
+{
+	state = state * 1664525u + 1013904223u;
+	return (state >> 8) / 8388608.0 - 1.0;
+}
+
+static double maxError(const std::vector<cplx>& a, const std::vector<cplx>& b)
+{
+	double error = 0;
+	for (size_t n = 0; n < a.size(); n += 1)
+		error = fmax(error, std::abs(a[n] - b[n]));
+	return error;
+}
+
+// FFT and chirp-Z against the direct sums they evaluate, and the time domain
+// transform against its definition and the closed form of a single delay.
+static void testTransforms()
+{
+	unsigned int state = 1;
+
+	const size_t N = 64;
+	FftPlan fft(N);
+	std::vector<cplx> x(N), X(N), direct(N);
+	for (size_t n = 0; n < N; n += 1)
+		x[n] = cplx(noise(state), noise(state));
+	for (size_t k = 0; k < N; k += 1)
+		for (size_t n = 0; n < N; n += 1)
+			direct[k] += x[n] * std::polar(1.0, -2 * M_PI * n * k / N);
+	X = x;
+	fft.forward(X.data());
+	check("FftPlan::forward vs direct DFT", maxError(X, direct), 1e-9);
+	fft.inverse(X.data());
+	for (size_t n = 0; n < N; n += 1)
+		X[n] /= (double)N;
+	check("FftPlan::inverse(forward(x)) / N vs x", maxError(X, x), 1e-12);
+
+	const size_t n_in = 37;
+	const size_t n_out = 53;
+	const double a = 0.3;
+	std::vector<cplx> in(n_in), pre(n_in), post(n_out), out(n_out), expected(n_out), scratch;
+	for (size_t n = 0; n < n_in; n += 1)
+	{
+		in[n] = cplx(noise(state), noise(state));
+		pre[n] = cplx(noise(state), noise(state));
+	}
+	for (size_t m = 0; m < n_out; m += 1)
+		post[m] = cplx(noise(state), noise(state));
+	for (size_t m = 0; m < n_out; m += 1)
+	{
+		for (size_t n = 0; n < n_in; n += 1)
+			expected[m] += pre[n] * in[n] * std::polar(1.0, a * n * m);
+		expected[m] *= post[m];
+	}
+	ChirpZ czt(n_in, n_out, a, pre, post);
+	czt.run(in.data(), out.data(), scratch);
+	check("ChirpZ vs direct sum", maxError(out, expected), 1e-9);
+
+	// A matched line of delay tau: S21(f) = e^(-j 2 pi f tau). Band-pass with a
+	// rectangular window is (1 / N) sum S21(f_n) e^(j 2 pi f_n t), which is 1 at t = tau.
+	const unsigned int F = 101;
+	const double tau = 5e-9;
+	std::vector<double> freqs(F), s_i(F), s_q(F);
+	for (unsigned int n = 0; n < F; n += 1)
+	{
+		freqs[n] = 1000 + n;
+		cplx s = std::polar(1.0, -2 * M_PI * freqs[n] * 1e6 * tau);
+		s_i[n] = s.real();
+		s_q[n] = s.imag();
+	}
+	TimeDomainConfig config = { TD_BANDPASS, WINDOW_RECT, 0, 0, 20e-9, 41 };
+	std::vector<double> td_i(config.points), td_q(config.points), times(config.points);
+	ComplexData td_in = { s_i.data(), s_q.data() };
+	ComplexData td_out = { td_i.data(), td_q.data() };
+	checkCode("timeDomainTransform", timeDomainTransform(freqs.data(), F, &td_in, 1, &config, &td_out, times.data()),
+	          ERR_OK);
+
+	std::vector<cplx> td(config.points), td_direct(config.points);
+	double time_error = 0;
+	for (unsigned int m = 0; m < config.points; m += 1)
+	{
+		td[m] = cplx(td_i[m], td_q[m]);
+		for (unsigned int n = 0; n < F; n += 1)
+			td_direct[m] += cplx(s_i[n], s_q[n]) * std::polar(1.0, 2 * M_PI * freqs[n] * 1e6 * times[m]) / (double)F;
+		time_error = fmax(time_error, fabs(times[m] - m * 0.5e-9));
+	}
+	check("timeDomainTransform time axis", time_error, 1e-18);
+	check("timeDomainTransform vs direct sum", maxError(td, td_direct), 1e-9);
+	check("timeDomainTransform delay peak = 1 at tau", std::abs(td[10] - 1.0), 1e-9);
+}
+
+// Gating a single delay: a pass gate centred on it returns the response as it
+// was, a notch over it takes it out. Hann window ends, which cannot be
+// recovered, come back as 0 and are left out of the pass check; the notch is
+// checked over the middle half of the band, away from the edge roll-off.
+static void testGate()
+{
+	const unsigned int F = 101;
+	const double tau = 20e-9;
+	std::vector<double> freqs(F), s_i(F), s_q(F), g_i(F), g_q(F);
+	for (unsigned int n = 0; n < F; n += 1)
+	{
+		freqs[n] = 1000 + 10.0 * n;
+		cplx s = std::polar(1.0, -2 * M_PI * freqs[n] * 1e6 * tau);
+		s_i[n] = s.real();
+		s_q[n] = s.imag();
+	}
+	ComplexData in = { s_i.data(), s_q.data() };
+	ComplexData out = { g_i.data(), g_q.data() };
+
+	GateConfig config = { tau - 10e-9, tau + 10e-9, WINDOW_HANN, 0, WINDOW_HANN, 0, false };
+	checkCode("timeDomainGate pass", timeDomainGate(freqs.data(), F, &in, 1, &config, &out), ERR_OK);
+	double pass_error = 0;
+	unsigned int kept = 0;
+	for (unsigned int n = 0; n < F; n += 1)
+	{
+		if (g_i[n] == 0 && g_q[n] == 0)
+			continue;
+		pass_error = fmax(pass_error, std::abs(cplx(g_i[n], g_q[n]) - cplx(s_i[n], s_q[n])));
+		kept += 1;
+	}
+	check("timeDomainGate pass gate on the delay vs input", pass_error, 1e-9);
+	check("timeDomainGate pass gate drops only the window ends", F - kept, 2);
+
+	config.notch = true;
+	checkCode("timeDomainGate notch", timeDomainGate(freqs.data(), F, &in, 1, &config, &out), ERR_OK);
+	double notch_level = 0;
+	for (unsigned int n = F / 4; n <= 3 * F / 4; n += 1)
+		notch_level = fmax(notch_level, std::abs(cplx(g_i[n], g_q[n])));
+	check("timeDomainGate notch over the delay, below -30 dB", notch_level, 0.03);
+}
+
+// Derived quantities against closed forms: a delay tau, e^(-j 2 pi f tau), has
+// phase -360 f tau degrees (-72 degrees per point here, so it wraps every 5
+// points) and group delay tau; |S| = 0.5 has VSWR 3 and -6.02 dB; S = 0 is Z0.
+static void testDerived()
+{
+	const unsigned int F = 101;
+	const double tau = 20e-9;
+	const double z0 = 50;
+	std::vector<double> freqs(F), s_i(F), s_q(F);
+	std::vector<double> log_mag(F), phase(F), delay(F), vswr(F), resistance(F), reactance(F);
+	for (unsigned int n = 0; n < F; n += 1)
+	{
+		freqs[n] = 1000 + 10.0 * n;
+		cplx s = std::polar(1.0, -2 * M_PI * freqs[n] * 1e6 * tau);
+		s_i[n] = s.real();
+		s_q[n] = s.imag();
+	}
+	ComplexData in = { s_i.data(), s_q.data() };
+	DerivedQuantities out = { NULL, phase.data(), delay.data(), NULL, NULL, NULL };
+	checkCode("computeDerivedQuantities delay", computeDerivedQuantities(freqs.data(), F, in, z0, &out), ERR_OK);
+	double phase_error = 0, delay_error = 0;
+	for (unsigned int n = 0; n < F; n += 1)
+	{
+		phase_error = fmax(phase_error, fabs(phase[n] - phase[0] + 360 * (freqs[n] - freqs[0]) * 1e6 * tau));
+		delay_error = fmax(delay_error, fabs(delay[n] - tau));
+	}
+	check("computeDerivedQuantities delay: unwrapped phase", phase_error, 1e-9);
+	check("computeDerivedQuantities delay: group delay = tau", delay_error, 1e-18);
+
+	// |S| = 0.5 all round the circle, then S = 0.
+	for (unsigned int n = 0; n < F; n += 1)
+	{
+		cplx s = std::polar(0.5, 2 * M_PI * n / F);
+		s_i[n] = s.real();
+		s_q[n] = s.imag();
+	}
+	DerivedQuantities match = { log_mag.data(), NULL, NULL, vswr.data(), NULL, NULL };
+	checkCode("computeDerivedQuantities |S| = 0.5", computeDerivedQuantities(NULL, F, in, z0, &match), ERR_OK);
+	double vswr_error = 0, log_mag_error = 0;
+	for (unsigned int n = 0; n < F; n += 1)
+	{
+		vswr_error = fmax(vswr_error, fabs(vswr[n] - 3));
+		log_mag_error = fmax(log_mag_error, fabs(log_mag[n] - 20 * log10(0.5)));
+	}
+	check("computeDerivedQuantities |S| = 0.5: VSWR = 3", vswr_error, 1e-12);
+	check("computeDerivedQuantities |S| = 0.5: 20 log10 0.5 dB", log_mag_error, 1e-12);
+
+	std::fill(s_i.begin(), s_i.end(), 0.0);
+	std::fill(s_q.begin(), s_q.end(), 0.0);
+	DerivedQuantities load = { NULL, NULL, NULL, NULL, resistance.data(), reactance.data() };
+	checkCode("computeDerivedQuantities S = 0", computeDerivedQuantities(NULL, F, in, z0, &load), ERR_OK);
+	double z_error = 0;
+	for (unsigned int n = 0; n < F; n += 1)
+		z_error = fmax(z_error, fabs(resistance[n] - z0) + fabs(reactance[n]));
+	check("computeDerivedQuantities S = 0: Z = Z0", z_error, 1e-12);
+}
+
+// Two-port data as four arrays of split I/Q, in the \ref NetworkFormat order 11, 21, 12, 22.
+struct TwoPort
+{
+	explicit TwoPort(size_t N) : i(4, std::vector<double>(N)), q(4, std::vector<double>(N))
+	{
+		for (int x = 0; x < 4; x += 1)
+		{
+			data[x].I = i[x].data();
+			data[x].Q = q[x].data();
+		}
+	}
+
+	cplx get(int x, size_t n) const { return cplx(i[x][n], q[x][n]); }
+	void set(int x, size_t n, cplx v) { i[x][n] = v.real(); q[x][n] = v.imag(); }
+
+	std::vector<std::vector<double> > i;
+	std::vector<std::vector<double> > q;
+	ComplexData data[4];
+};
+
+static double maxError(const TwoPort& a, const TwoPort& b)
+{
+	double error = 0;
+	for (int x = 0; x < 4; x += 1)
+		for (size_t n = 0; n < a.i[x].size(); n += 1)
+			error = fmax(error, std::abs(a.get(x, n) - b.get(x, n)));
+	return error;
+}
+
+// ABCD matrix product a * b, in the same element order.
+static void cascadeAbcd(const cplx a[4], const cplx b[4], cplx r[4])
+{
+	r[0] = a[0] * b[0] + a[2] * b[1];
+	r[1] = a[1] * b[0] + a[3] * b[1];
+	r[2] = a[0] * b[2] + a[2] * b[3];
+	r[3] = a[1] * b[2] + a[3] * b[3];
+}
+
+// Network conversions against the closed form of a series impedance, and
+// de-embedding of fixtures and port extensions cascaded with ABCD matrices.
+static void testDeembedding()
+{
+	const double z0 = 50;
+	const size_t N = 5;
+	unsigned int state = 2;
+
+	// Series Z: ABCD = [1 Z; 0 1], S11 = S22 = Z / (Z + 2 z0), S21 = S12 = 2 z0 / (Z + 2 z0).
+	TwoPort abcd(N), s(N), expected(N), back(N);
+	for (size_t n = 0; n < N; n += 1)
+	{
+		cplx z(10.0 * (n + 1), -20.0 + 15.0 * n);
+		abcd.set(0, n, 1.0);
+		abcd.set(1, n, 0.0);
+		abcd.set(2, n, z);
+		abcd.set(3, n, 1.0);
+		expected.set(0, n, z / (z + 2 * z0));
+		expected.set(1, n, 2 * z0 / (z + 2 * z0));
+		expected.set(2, n, 2 * z0 / (z + 2 * z0));
+		expected.set(3, n, z / (z + 2 * z0));
+	}
+	checkCode("convertTwoPort ABCD -> S", convertTwoPort(N, abcd.data, NETWORK_ABCD, NETWORK_S, z0, s.data), ERR_OK);
+	check("convertTwoPort series Z vs closed form", maxError(s, expected), 1e-12);
+	convertTwoPort(N, s.data, NETWORK_S, NETWORK_ABCD, z0, back.data);
+	check("convertTwoPort S -> ABCD round trip", maxError(back, abcd), 1e-12);
+
+	TwoPort dut(N), t(N);
+	for (int x = 0; x < 4; x += 1)
+		for (size_t n = 0; n < N; n += 1)
+			dut.set(x, n, cplx(noise(state), noise(state)));
+	convertTwoPort(N, dut.data, NETWORK_S, NETWORK_T, z0, t.data);
+	convertTwoPort(N, t.data, NETWORK_T, NETWORK_S, z0, back.data);
+	check("convertTwoPort S -> T -> S round trip", maxError(back, dut), 1e-12);
+
+	// Fixtures are L sections (series Z, then shunt Y), so they are not
+	// symmetric and a swapped port would show. Port extensions are matched
+	// lines, ABCD = [cos wt, j z0 sin wt; j sin wt / z0, cos wt].
+	const double delay1 = 120e-12;
+	const double delay2 = 75e-12;
+	std::vector<double> freqs(N);
+	TwoPort fixture1_abcd(N), fixture2_abcd(N), dut_abcd(N), measured_abcd(N);
+	convertTwoPort(N, dut.data, NETWORK_S, NETWORK_ABCD, z0, dut_abcd.data);
+	for (size_t n = 0; n < N; n += 1)
+	{
+		freqs[n] = 1000 + 250 * n;
+		cplx y1(0.004, 0.002 * n), z1(15, 5.0 * n);
+		cplx y2(0.001 * n, -0.003), z2(8.0 * n, -12);
+		cplx f1[4] = { 1.0 + z1 * y1, y1, z1, 1.0 };
+		cplx f2[4] = { 1.0 + z2 * y2, y2, z2, 1.0 };
+
+		double w = 2 * M_PI * freqs[n] * 1e6;
+		cplx l1[4] = { cos(w * delay1), cplx(0, sin(w * delay1) / z0), cplx(0, z0 * sin(w * delay1)), cos(w * delay1) };
+		cplx l2[4] = { cos(w * delay2), cplx(0, sin(w * delay2) / z0), cplx(0, z0 * sin(w * delay2)), cos(w * delay2) };
+		cplx d[4] = { dut_abcd.get(0, n), dut_abcd.get(1, n), dut_abcd.get(2, n), dut_abcd.get(3, n) };
+
+		cplx a[4], b[4];
+		cascadeAbcd(f1, l1, a);
+		cascadeAbcd(a, d, b);
+		cascadeAbcd(b, l2, a);
+		cascadeAbcd(a, f2, b);
+		for (int x = 0; x < 4; x += 1)
+		{
+			fixture1_abcd.set(x, n, f1[x]);
+			fixture2_abcd.set(x, n, f2[x]);
+			measured_abcd.set(x, n, b[x]);
+		}
+	}
+
+	TwoPort fixture1(N), fixture2(N), measured(N), recovered(N);
+	convertTwoPort(N, fixture1_abcd.data, NETWORK_ABCD, NETWORK_S, z0, fixture1.data);
+	convertTwoPort(N, fixture2_abcd.data, NETWORK_ABCD, NETWORK_S, z0, fixture2.data);
+	convertTwoPort(N, measured_abcd.data, NETWORK_ABCD, NETWORK_S, z0, measured.data);
+
+	TaskHandle task = createTask();
+	checkCode("setDeembedding", setDeembedding(task, freqs.data(), N, fixture1.data, fixture2.data, delay1, delay2),
+	          ERR_OK);
+	checkCode("deembedSweeps", deembedSweeps(task, measured.data, 1, recovered.data), ERR_OK);
+	check("deembedSweeps recovers the DUT", maxError(recovered, dut), 1e-9);
+	deleteTaskExtensions(task);
+	deleteTask(task);
+}
+
+// Running statistics of a linear ramp x_k = base + k step, k < K, which has
+// mean base + step (K - 1) / 2 and unbiased variance |step|^2 K (K + 1) / 12.
+// A large base with a small step is where a sum-of-squares variance fails.
+static void testStatistics()
+{
+	const unsigned int N = 4;
+	const unsigned int K = 1000;
+	const cplx base[N] = { cplx(1, -2), cplx(1e6, 1e6), cplx(-3e3, 0.5), cplx(0, 0) };
+	const cplx step[N] = { cplx(0.25, 0.5), cplx(1e-3, -2e-3), cplx(0, 1), cplx(-1, 1) };
+
+	StatisticsHandle stats = createStatistics();
+	std::vector<double> x_i(N), x_q(N), min_direct(N, INFINITY), max_direct(N, 0);
+	ComplexData x = { x_i.data(), x_q.data() };
+	ComplexData none = { NULL, NULL };
+	ErrCode code = ERR_OK;
+	for (unsigned int k = 0; k < K && code == ERR_OK; k += 1)
+	{
+		for (unsigned int n = 0; n < N; n += 1)
+		{
+			cplx v = base[n] + (double)k * step[n];
+			x_i[n] = v.real();
+			x_q[n] = v.imag();
+			min_direct[n] = fmin(min_direct[n], std::abs(v));
+			max_direct[n] = fmax(max_direct[n], std::abs(v));
+		}
+		code = addToStatistics(stats, N, x, none, none, none, none);
+	}
+	checkCode("addToStatistics", code, ERR_OK);
+
+	unsigned int sweeps = 0;
+	std::vector<double> mean_i(N), mean_q(N), variance(N), min_mag(N), max_mag(N);
+	ComplexData mean = { mean_i.data(), mean_q.data() };
+	checkCode("getStatistics", getStatistics(stats, 0, &sweeps, mean, variance.data(), min_mag.data(), max_mag.data()),
+	          ERR_OK);
+	check("getStatistics sweep count", fabs((double)sweeps - K), 0);
+
+	double mean_error = 0, variance_error = 0, extreme_error = 0;
+	for (unsigned int n = 0; n < N; n += 1)
+	{
+		cplx expected_mean = base[n] + step[n] * ((K - 1) / 2.0);
+		double expected_variance = std::norm(step[n]) * K * (K + 1) / 12.0;
+		mean_error = fmax(mean_error, std::abs(cplx(mean_i[n], mean_q[n]) - expected_mean) / std::abs(expected_mean));
+		variance_error = fmax(variance_error, fabs(variance[n] - expected_variance) / expected_variance);
+		extreme_error = fmax(extreme_error, fabs(min_mag[n] - min_direct[n]) + fabs(max_mag[n] - max_direct[n]));
+	}
+	check("getStatistics mean vs closed form (relative)", mean_error, 1e-12);
+	check("getStatistics variance vs closed form (relative)", variance_error, 1e-6);
+	check("getStatistics min/max magnitude vs direct", extreme_error, 1e-9);
+
+	ComplexData half = { x_i.data(), NULL };
+	addToStatistics(stats, N, x, half, none, none, none);
+	getStatistics(stats, 1, &sweeps, none, NULL, NULL, NULL);
+	check("addToStatistics skips an output without Q", sweeps, 0);
+	checkCode("addToStatistics point count mismatch", addToStatistics(stats, N - 1, x, none, none, none, none),
+	          ERR_MISSING_FREQS);
+	deleteStatistics(stats);
+}
+
+// Ratio kernels against std::complex division; a dead Ref point gives 0.
+static void testRatio()
+{
+	const size_t N = 257;
+	unsigned int state = 3;
+	std::vector<double> ref_i(N), ref_q(N), rec_i(N), rec_q(N), x_i(N), x_q(N);
+	std::vector<cplx> expected_rec(N), expected_ratio(N), rec(N), ratio(N);
+	for (size_t n = 0; n < N; n += 1)
+	{
+		// Magnitudes from 1e-6 to 1e3, plus two points with no power at all.
+		cplx ref = std::polar(pow(10.0, 9 * (noise(state) + 1) / 2 - 6), M_PI * noise(state));
+		if (n == 17 || n == 200)
+			ref = 0;
+		cplx x(noise(state), noise(state));
+		ref_i[n] = ref.real();
+		ref_q[n] = ref.imag();
+		x_i[n] = x.real();
+		x_q[n] = x.imag();
+		expected_rec[n] = ref == 0.0 ? 0.0 : 1.0 / ref;
+		expected_ratio[n] = ref == 0.0 ? 0.0 : x / ref;
+	}
+
+	referenceReciprocal(ref_i.data(), ref_q.data(), rec_i.data(), rec_q.data(), N);
+	multiplyComplex(x_i.data(), x_q.data(), rec_i.data(), rec_q.data(), N);
+	double rec_error = 0, ratio_error = 0;
+	for (size_t n = 0; n < N; n += 1)
+	{
+		double scale = fmax(std::abs(expected_rec[n]), 1.0);
+		rec_error = fmax(rec_error, std::abs(cplx(rec_i[n], rec_q[n]) - expected_rec[n]) / scale);
+		ratio_error = fmax(ratio_error, std::abs(cplx(x_i[n], x_q[n]) - expected_ratio[n]) / scale);
+	}
+	check("referenceReciprocal vs 1 / ref (relative)", rec_error, 1e-12);
+	check("multiplyComplex by reciprocal vs x / ref (relative)", ratio_error, 1e-12);
+	check("referenceReciprocal dead Ref point gives 0", fabs(rec_i[17]) + fabs(rec_q[17]) + fabs(x_i[200]), 0);
+}
+
+// Background subtraction: a fixed background taken from a trace cancels that
+// trace exactly, and an adaptive one started at 0 under a constant sweep x
+// leaves x (1 - alpha)^k after k sweeps.
+static void testBaseline()
+{
+	const unsigned int N = 5;
+	const double alpha = 0.25;
+	unsigned int state = 4;
+
+	TaskHandle task = createTask();
+	ExtTask* et = getExtTask(task);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->plan.active = true;
+		et->plan.freqs.assign(N, 1000);
+	}
+
+	std::vector<double> b_i(N), b_q(N), x_i(N), x_q(N);
+	for (unsigned int n = 0; n < N; n += 1)
+	{
+		b_i[n] = noise(state);
+		b_q[n] = noise(state);
+	}
+	ComplexData background = { b_i.data(), b_q.data() };
+	ComplexData none = { NULL, NULL };
+	ComplexData out[NUM_OUTPUTS] = { { x_i.data(), x_q.data() } };
+	checkCode("setBaseline", setBaseline(task, N, background, none, none, none, none), ERR_OK);
+	x_i = b_i;
+	x_q = b_q;
+	checkCode("applyBaseline fixed", applyBaseline(et, out), ERR_OK);
+	double fixed_error = 0;
+	for (unsigned int n = 0; n < N; n += 1)
+		fixed_error = fmax(fixed_error, fabs(x_i[n]) + fabs(x_q[n]));
+	check("applyBaseline fixed: own trace subtracts to 0", fixed_error, 0);
+
+	std::vector<double> zero(N);
+	ComplexData start = { zero.data(), zero.data() };
+	setBaseline(task, N, start, none, none, none, none);
+	checkCode("setBaselineAdaptation", setBaselineAdaptation(task, alpha), ERR_OK);
+	double adapt_error = 0;
+	for (unsigned int k = 0; k < 20; k += 1)
+	{
+		x_i = b_i;
+		x_q = b_q;
+		applyBaseline(et, out);
+		double remaining = pow(1 - alpha, k);
+		for (unsigned int n = 0; n < N; n += 1)
+			adapt_error = fmax(adapt_error, fabs(x_i[n] - b_i[n] * remaining) + fabs(x_q[n] - b_q[n] * remaining));
+	}
+	check("applyBaseline adaptive vs x (1 - alpha)^k", adapt_error, 1e-12);
+
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->plan.freqs.assign(N + 1, 1000);
+	}
+	setBaselineAdaptation(task, 0);
+	checkCode("applyBaseline fixed, point count mismatch", applyBaseline(et, out), ERR_MISSING_FREQS);
+
+	deleteTaskExtensions(task);
+	deleteTask(task);
+}
+
+// A ratio -> average -> window -> inverse FFT -> magnitude -> decimate pipeline
+// over a sweep of several 512 point chunks, against the same stages applied one
+// after the other to the whole sweep, for T1R1 and for Ref (which the ratio
+// passes through). A flat spectrum through the inverse FFT alone is 1 at t = 0.
+static void testPipeline()
+{
+	const unsigned int N = 1500;
+	const unsigned int AVERAGE = 3;
+	const unsigned int FACTOR = 3;
+	const unsigned int SWEEPS = 5;
+	const size_t L = nextPowerOfTwo(N);
+	unsigned int state = 5;
+
+	PipelineHandle pipeline = createPipeline();
+	addRatioStage(pipeline);
+	addAverageStage(pipeline, AVERAGE);
+	addWindowStage(pipeline, WINDOW_HANN, 0);
+	addInverseFftStage(pipeline, 0);
+	addMagnitudeStage(pipeline, false);
+	addDecimationStage(pipeline, FACTOR);
+	const unsigned int P = getPipelineOutputPoints(pipeline, N);
+	check("getPipelineOutputPoints", fabs((double)P - L / FACTOR), 0);
+
+	TaskHandle task = createTask();
+	checkCode("attachPipeline", attachPipeline(task, pipeline), ERR_OK);
+	deletePipeline(pipeline);
+
+	// Without hardware, feed the sweeps the way measureInto() does.
+	ExtTask* et = getExtTask(task);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->plan.active = true;
+		et->plan.freqs.assign(N, 1000);
+		et->in_flight = true;
+	}
+
+	const int paths[2] = { 0, 4 };
+	std::vector<double> out_i[2], out_q[2];
+	std::vector<cplx> average[2];
+	ComplexData out[NUM_OUTPUTS] = {};
+	for (int y = 0; y < 2; y += 1)
+	{
+		out_i[y].resize(P);
+		out_q[y].resize(P);
+		out[paths[y]].I = out_i[y].data();
+		out[paths[y]].Q = out_q[y].data();
+		average[y].assign(N, 0.0);
+	}
+
+	FftPlan fft(L);
+	std::vector<double> rec_i(N), rec_q(N), x_i(N), x_q(N);
+	std::vector<cplx> work(L);
+	double pipeline_error = 0;
+	for (unsigned int k = 0; k < SWEEPS; k += 1)
+	{
+		ComplexData raw[NUM_OUTPUTS];
+		pipelineInput(et, MEAS_UNCALIBRATED, raw);
+		for (int x = 0; x < NUM_OUTPUTS; x += 1)
+		{
+			for (unsigned int n = 0; n < N; n += 1)
+			{
+				raw[x].I[n] = noise(state) + (x == 4 ? 2 : 0);
+				raw[x].Q[n] = noise(state);
+			}
+		}
+		runPipeline(et, MEAS_UNCALIBRATED, raw, out);
+
+		referenceReciprocal(raw[4].I, raw[4].Q, rec_i.data(), rec_q.data(), N);
+		for (int y = 0; y < 2; y += 1)
+		{
+			x_i.assign(raw[paths[y]].I, raw[paths[y]].I + N);
+			x_q.assign(raw[paths[y]].Q, raw[paths[y]].Q + N);
+			if (paths[y] != 4)
+				multiplyComplex(x_i.data(), x_q.data(), rec_i.data(), rec_q.data(), N);
+
+			double weight = 1.0 / std::min(k + 1, AVERAGE);
+			std::fill(work.begin(), work.end(), cplx(0, 0));
+			for (unsigned int n = 0; n < N; n += 1)
+			{
+				average[y][n] += (cplx(x_i[n], x_q[n]) - average[y][n]) * weight;
+				work[n] = average[y][n] * windowValue(WINDOW_HANN, 0, (double)n / (N - 1));
+			}
+			fft.inverse(work.data());
+			for (unsigned int p = 0; p < P; p += 1)
+			{
+				double expected = 0;
+				for (unsigned int z = 0; z < FACTOR; z += 1)
+					expected += std::abs(work[p * FACTOR + z]) / N;
+				expected /= FACTOR;
+				pipeline_error = fmax(pipeline_error, fabs(out_i[y][p] - expected) + fabs(out_q[y][p]));
+			}
+		}
+	}
+	check("pipeline vs the stages one by one", pipeline_error, 1e-12);
+
+	// Inverse FFT scaling: N ones zero-padded to L.
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->in_flight = false;
+	}
+	PipelineHandle inverse = createPipeline();
+	addInverseFftStage(inverse, 0);
+	checkCode("attachPipeline inverse FFT only", attachPipeline(task, inverse), ERR_OK);
+	deletePipeline(inverse);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->in_flight = true;
+	}
+	std::vector<double> td_i(L), td_q(L);
+	ComplexData td[NUM_OUTPUTS] = { { td_i.data(), td_q.data() } };
+	ComplexData raw[NUM_OUTPUTS];
+	pipelineInput(et, MEAS_UNCALIBRATED, raw);
+	for (unsigned int n = 0; n < N; n += 1)
+	{
+		raw[0].I[n] = 1;
+		raw[0].Q[n] = 0;
+	}
+	runPipeline(et, MEAS_UNCALIBRATED, raw, td);
+	check("pipeline inverse FFT of a flat spectrum = 1 at t = 0", std::abs(cplx(td_i[0], td_q[0]) - 1.0), 1e-12);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->in_flight = false;
+	}
+
+	deleteTaskExtensions(task);
+	deleteTask(task);
+}
+
+// Doppler maps against a direct DFT across the sweeps, with zero Doppler in
+// the middle row: range bin 0 is static, bin 1 moves at +5 and bin 2 at -3
+// Doppler bins per block.
+static void testDoppler()
+{
+	const unsigned int R = 3;
+	const unsigned int M = 16;
+	const unsigned int D = 32;
+	const int shift[R] = { 0, 5, -3 };
+
+	TaskHandle task = createTask();
+	DopplerConfig config = { 0, M, D, WINDOW_RECT, 0 };
+	checkCode("startDoppler", startDoppler(task, &config), ERR_OK);
+
+	// Without hardware there is no sweep to measure: give the Task an R point
+	// plan and feed the sweeps the way measureInto() does.
+	ExtTask* et = getExtTask(task);
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->plan.active = true;
+		et->plan.freqs.assign(R, 1000);
+		et->in_flight = true;
+	}
+	std::vector<double> x_i(R), x_q(R);
+	ComplexData out[NUM_OUTPUTS] = { { x_i.data(), x_q.data() } };
+	for (unsigned int m = 0; m < M; m += 1)
+	{
+		for (unsigned int r = 0; r < R; r += 1)
+		{
+			cplx x = std::polar(1.0 + r, 2 * M_PI * shift[r] * m / D);
+			x_i[r] = x.real();
+			x_q[r] = x.imag();
+		}
+		feedDoppler(et, out);
+	}
+	{
+		std::lock_guard<std::mutex> guard(et->lock);
+		et->in_flight = false;
+	}
+
+	// The block is transformed on the compute pool.
+	std::vector<double> map_i(R * D), map_q(R * D);
+	ComplexData map = { map_i.data(), map_q.data() };
+	DopplerMapInfo info;
+	ErrCode code = ERR_WRONG_STATE;
+	for (int tries = 0; tries < 1000 && code != ERR_OK; tries += 1)
+	{
+		code = getDopplerMap(task, map, &info);
+		if (code != ERR_OK)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	checkCode("getDopplerMap", code, ERR_OK);
+	check("getDopplerMap shape", fabs((double)info.range_bins - R) + fabs((double)info.doppler_bins - D), 0);
+
+	double map_error = 0, peak_error = 0;
+	for (unsigned int r = 0; r < R && code == ERR_OK; r += 1)
+	{
+		unsigned int peak = 0;
+		for (unsigned int k = 0; k < D; k += 1)
+		{
+			cplx expected = 0;
+			for (unsigned int m = 0; m < M; m += 1)
+				expected += std::polar(1.0 + r, 2 * M_PI * ((double)shift[r] - ((double)k - D / 2)) * m / D);
+			cplx value(map_i[r * D + k], map_q[r * D + k]);
+			map_error = fmax(map_error, std::abs(value - expected));
+			if (std::abs(value) > std::abs(cplx(map_i[r * D + peak], map_q[r * D + peak])))
+				peak = k;
+		}
+		peak_error = fmax(peak_error, fabs((double)peak - (D / 2 + shift[r])));
+	}
+	check("getDopplerMap vs direct DFT", map_error, 1e-9);
+	check("getDopplerMap peaks at D / 2 + Doppler shift", peak_error, 0);
+
+	deleteTaskExtensions(task);
+	deleteTask(task);
+}
+
+int main()
+{
+	testTransforms();
+	testGate();
+	testDerived();
+	testDeembedding();
+	testStatistics();
+	testRatio();
+	testBaseline();
+	testPipeline();
+	testDoppler();
+
+	if (failures)
+		printf("\n%d check(s) FAILED\n", failures);
+	else
+		printf("\nAll checks passed\n");
+	return failures ? 1 : 0;
+}
@@ -5,7 +5,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <chrono>
+#include <thread>
 #include "vna_header_agg_c.h"
+#include "vnadll_ext.h"
 
 #define TEST_TARGET_IP_VNA "192.168.1.193"
 
@@ -377,13 +380,178 @@ int main(int argc, char* argv[])
 		delete [] t1r1.Q;
 	}
 
+	{
+		printf("\nCancelling a submitted measurement at every hop rate\n");
+		struct { HopRate hop; const char* name; double points_per_second; } rates[] = {
+			{ HOP_45K, "45K", 45000 }, { HOP_30K, "30K", 30000 }, { HOP_15K, "15K", 15000 },
+			{ HOP_7K, "7K", 7000 }, { HOP_3K, "3K", 3000 }, { HOP_2K, "2K", 2000 },
+			{ HOP_1K, "1K", 1000 }, { HOP_550, "550", 550 }, { HOP_312, "312", 312 },
+			{ HOP_156, "156", 156 }, { HOP_78, "78", 78 }, { HOP_39, "39", 39 },
+			{ HOP_20, "20", 20 } };
+		ComplexData dontcare = { NULL, NULL };
+		for (unsigned int r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r)
+		{
+			// A sweep of about 50 ms (at least 10 points), so the measurement is
+			// still running when it is cancelled 5 ms in.
+			unsigned int points = (unsigned int)(rates[r].points_per_second * 0.05);
+			if (points < 10)
+				points = 10;
+			if (points > (unsigned int)details.maximum_points)
+				points = details.maximum_points;
+			code = stop(task);
+			logCodeAndQuitIfError(code);
+			code = setHopRate(task, rates[r].hop);
+			logCodeAndQuitIfError(code);
+			code = utilGenerateLinearSweep(task, details.minimum_frequency, details.maximum_frequency, points);
+			logCodeAndQuitIfError(code);
+			code = start(task);
+			logCodeAndQuitIfError(code);
+
+			code = submitMeasurement(task, MEAS_UNCALIBRATED);
+			logCodeAndQuitIfError(code);
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			code = cancelMeasurement(task);
+			bool ready = isMeasurementReady(task);
+			while (!ready && std::chrono::steady_clock::now() - begin < std::chrono::seconds(1))
+				ready = isMeasurementReady(task);
+			double latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+			logCodeAndQuitIfError(code);
+			printf("HOP_%s, %u points: cancel to completion %.1f us\n", rates[r].name, points, latency);
+
+			code = reapMeasurement(task, dontcare, dontcare, dontcare, dontcare, dontcare);
+			if (!ready || code != ERR_INTERRUPTED)
+			{
+				printf("Measurement was not completed with ERR_INTERRUPTED by cancelMeasurement()\n");
+				logCodeAndQuitIfError(ERR_WRONG_STATE);
+			}
+			if (latency > 1000)
+			{
+				printf("Cancel to completion took more than 1 ms\n");
+				logCodeAndQuitIfError(ERR_WRONG_STATE);
+			}
+
+			// The next measurement starts once the interrupted call has returned.
+			code = submitMeasurement(task, MEAS_UNCALIBRATED);
+			logCodeAndQuitIfError(code);
+			while (!isMeasurementReady(task))
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			code = reapMeasurement(task, dontcare, dontcare, dontcare, dontcare, dontcare);
+			logCodeAndQuitIfError(code);
+		}
+
+		printf("Back to HOP_45K and 1024 points\n");
+		code = stop(task);
+		logCodeAndQuitIfError(code);
+		code = setHopRate(task, HOP_45K);
+		logCodeAndQuitIfError(code);
+		code = utilGenerateLinearSweep(task, details.minimum_frequency, details.maximum_frequency, 1024);
+		logCodeAndQuitIfError(code);
+		code = start(task);
+		logCodeAndQuitIfError(code);
+	}
+
+	{
+		printf("\nMeasuring outputs with only one of their arrays\n");
+		unsigned int n = getSegmentedNumberOfFrequencies(task);
+		ComplexData s11_real = { new double[n], NULL };
+		ComplexData s21_imag = { NULL, new double[n] };
+		ComplexData dontcare = { NULL, NULL };
+		for (unsigned int i = 0; i < n; ++i)
+			s11_real.I[i] = s21_imag.Q[i] = NAN;
+		code = measureSegmented(task, MEAS_2PORT_CALIBRATED, s11_real, s21_imag, dontcare, dontcare, dontcare);
+		logCodeAndQuitIfError(code);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			if (isnan(s11_real.I[i]) || isnan(s21_imag.Q[i]))
+			{
+				printf("Point %u was not measured\n", i);
+				logCodeAndQuitIfError(ERR_WRONG_STATE);
+			}
+		}
+
+		printf("Uncalibrated T1R1.I alone, with the full Ref output\n");
+		ComplexData t1r1_real = { new double[n], NULL };
+		ComplexData ref = { new double[n], new double[n] };
+		for (unsigned int i = 0; i < n; ++i)
+			t1r1_real.I[i] = ref.I[i] = ref.Q[i] = NAN;
+		code = measureSegmented(task, MEAS_UNCALIBRATED, t1r1_real, dontcare, dontcare, dontcare, ref);
+		logCodeAndQuitIfError(code);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			if (isnan(t1r1_real.I[i]) || isnan(ref.I[i]) || isnan(ref.Q[i]))
+			{
+				printf("Point %u was not measured\n", i);
+				logCodeAndQuitIfError(ERR_WRONG_STATE);
+			}
+		}
+		delete [] t1r1_real.I;
+		delete [] ref.I;
+		delete [] ref.Q;
+
+		printf("Averaging S11.I alone over 4 sweeps\n");
+		code = setAveraging(task, AVERAGE_EXPONENTIAL, 4);
+		logCodeAndQuitIfError(code);
+		for (int x = 0; x < 4; x += 1)
+		{
+			code = measureSegmented(task, MEAS_2PORT_CALIBRATED, s11_real, dontcare, dontcare, dontcare, dontcare);
+			logCodeAndQuitIfError(code);
+		}
+		code = setAveraging(task, AVERAGE_OFF, 1);
+		logCodeAndQuitIfError(code);
+		printf("S11.I\tS21.Q\n");
+		for (unsigned int i = 0; i < 5; ++i)
+			printf("%.2f\t%.2f\n", s11_real.I[i], s21_imag.Q[i]);
+
+		delete [] s11_real.I;
+		delete [] s21_imag.Q;
+	}
+
 
 	printf("\nStopping the task\n");
 	code = stop(task);
 	logCodeAndQuitIfError(code);
 
+	{
+		printf("\nSweep segment of 2 x maximum_points + 1 points, up to the maximum frequency\n");
+		SweepSegment segment = {
+			(double)details.minimum_frequency, (double)details.maximum_frequency,
+			2 * (unsigned int)details.maximum_points + 1, HOP_UNDEFINED, ATTEN_UNDEFINED };
+		code = setSweepSegments(task, &segment, 1);
+		logCodeAndQuitIfError(code);
+
+		unsigned int n = getSegmentedNumberOfFrequencies(task);
+		double* f = new double[n];
+		code = getSegmentedFrequencies(task, f, n);
+		logCodeAndQuitIfError(code);
+		printf("%u points, %f .. %f MHz\n", n, f[0], f[n - 1]);
+		if (n != segment.points || f[n - 1] > details.maximum_frequency
+		    || fabs(f[n - 1] - details.maximum_frequency) > 1)
+		{
+			printf("Segment does not end at the maximum frequency\n");
+			logCodeAndQuitIfError(ERR_FREQ_OUT_OF_BOUNDS);
+		}
+
+		ComplexData t1r1 = { new double[n], new double[n] };
+		ComplexData dontcare = { NULL, NULL };
+		code = start(task);
+		logCodeAndQuitIfError(code);
+		code = measureSegmented(task, MEAS_UNCALIBRATED, t1r1, dontcare, dontcare, dontcare, dontcare);
+		logCodeAndQuitIfError(code);
+		code = stop(task);
+		logCodeAndQuitIfError(code);
+		code = clearSegmentedFrequencies(task);
+		logCodeAndQuitIfError(code);
+
+		delete [] f;
+		delete [] t1r1.I;
+		delete [] t1r1.Q;
+	}
+
 	printf("Deleting task\n");
 
+	deleteTaskExtensions(task);
 	deleteTask(task);
 
 	printf("Goodbye\n");
@@ -11,6 +11,7 @@ from . import vnalibrary as vna
 from . import vnaexceptions
 import collections
 import pickle
+import threading
 import time
 import logging
 
@@ -278,5 +279,56 @@ class VNA(vna.RAW_VNA):
 		self.importCalibration(cal_f, *cal_p)
 
 
+def connect_many(targets, loglevel=logging.INFO):
+	''' Connect and initialize several remote VNAs concurrently.
+
+		Each `VNA()` instance is created on its own thread. The DLL calls
+		release the GIL, so the (slow) initialization of every unit overlaps,
+		and bringing up a fleet takes about as long as the slowest unit rather
+		than the sum of all of them.
+
+		Args:
+			targets		-- list of `(device_ip, device_ip_port)` or
+			                   `(device_ip, device_ip_port, vna_no)` tuples, with
+			                   the same meaning as the `VNA()` arguments. Each
+			                   unit must use a unique port.
+			loglevel	-- (logging level) Passed through to every `VNA()` instance.
+
+		Returns:
+			List of \ref VNA instances, in the same order as `targets`.
+
+		---
+		\exceptions The first exception raised by any of the `VNA()` constructors,
+		            after all of the other units have finished initializing. The
+		            units that did connect are closed (`deleteTask()`) first.
+	'''
+
+	vnas   = [None] * len(targets)
+	errors = [None] * len(targets)
+
+	def connect(idx, target):
+		try:
+			vnas[idx] = VNA(*target, loglevel=loglevel)
+		except Exception as e:
+			errors[idx] = e
+
+	threads = [
+			threading.Thread(target=connect, args=(idx, tuple(target)))
+			for idx, target in enumerate(targets)
+		]
+	for thread in threads:
+		thread.start()
+	for thread in threads:
+		thread.join()
+
+	for error in errors:
+		if error is not None:
+			for vna_instance in vnas:
+				if vna_instance is not None:
+					vna_instance.deleteTask()
+			raise error
+
+	return vnas
+
 # end doxygen block
 ## @}
@@ -591,3 +591,44 @@ class TestVnaHighLevelAcquisition(unittest.TestCase):
 		self.vna.stop()
 
 
+class TestVnaConnectMany(unittest.TestCase):
+
+	def test_connect_many(self):
+		# Same port-retry dance as resilient_highlevel(), one port per unit.
+		for port in range(1025, 5000, 2):
+			time.sleep(0.1)
+			try:
+				vnas = VNA.connect_many([(TEST_ADDRESS, port), (TEST_ADDRESS, port + 1, "second")])
+				break
+			except VNA.VNA_Exception_Socket as e:
+				if port > 1200:
+					raise e
+				time.sleep(0.1)
+
+		self.assertEqual(len(vnas), 2)
+		self.assertEqual(vnas[0].getIPPort(), port)
+		self.assertEqual(vnas[1].getIPPort(), port + 1)
+		self.assertEqual(vnas[1].log.name, "Main.VNA-API-second")
+		for vna_instance in vnas:
+			self.assertEqual(vna_instance.getState(), VNA.TASK_STOPPED)
+			vna_instance.deleteTask()
+
+	def test_connect_many_failure_closes_connected(self):
+		closed = []
+		delete_task = VNA.RAW_VNA.deleteTask
+		def record_delete(vna_instance):
+			closed.append(vna_instance.getIPAddress())
+			delete_task(vna_instance)
+
+		# 192.0.2.0/24 is reserved for documentation, so nothing answers there.
+		# The unit that did connect must be closed before the error propagates,
+		# not later by the garbage collector, so look while it is being handled.
+		VNA.RAW_VNA.deleteTask = record_delete
+		try:
+			VNA.connect_many([(TEST_ADDRESS, 1101), ("192.0.2.1", 1102)])
+		except VNA.VNA_Exception:
+			self.assertIn(TEST_ADDRESS, closed)
+		else:
+			self.fail("connect_many() did not raise")
+		finally:
+			VNA.RAW_VNA.deleteTask = delete_task